@@ -1,9 +1,11 @@
 #include "robot.h"
 #include "command.h"
+#include "serial_line_reader.h"
+#include "serial_reply_writer.h"
 #include <Arduino.h>
 
 // Arduino sketch entry point.
-// Receives text commands over Serial, updates robot state via fetch(),
+// Receives text commands (plain or G-code) over Serial, updates robot state via fetch(),
 // and performs incremental motion via robot.update() in the main loop.
 
 // Step/dir pin assignments for each axis driver
@@ -22,12 +24,31 @@
 // Enable pin for motor drivers (active level depends on the driver)
 #define EN_PIN 8
 
-// Initialize stepper motors (step pin, dir pin, pulse width in microseconds)
-// pulse width: interval between HIGH and LOW on STEP pin (µs)
-StepperMotor motor_x(STEP_PIN_X, DIR_PIN_X, 1000); // 1000 µs between HIGH and LOW pulses
-StepperMotor motor_y(STEP_PIN_Y, DIR_PIN_Y, 1000);
-StepperMotor motor_z(STEP_PIN_Z, DIR_PIN_Z, 1000);
-StepperMotor motor_a(STEP_PIN_A, DIR_PIN_A, 1000);
+// Uncomment once every driver's microstep inputs are rewired (see README.md).
+// Without it the drivers must run in full steps (no microstep jumpers set).
+// #define MICROSTEP_CONTROL
+
+#ifdef MICROSTEP_CONTROL
+// Microstep-select pin of each driver (MS1, MS2 and MS3 bridged to it
+// instead of the shield's jumpers; LOW = full steps, HIGH = 1/16 steps).
+// On the CNC shield these are the X/Y/Z endstop and Abort headers.
+#define MS_PIN_X 9
+#define MS_PIN_Y 10
+#define MS_PIN_Z 11
+#define MS_PIN_A A0
+#else
+#define MS_PIN_X -1
+#define MS_PIN_Y -1
+#define MS_PIN_Z -1
+#define MS_PIN_A -1
+#endif
+
+// Initialize stepper motors (step pin, dir pin, pulse width in microseconds, microstep pin or -1)
+// pulse width: interval between HIGH and LOW on STEP pin (µs, in full steps)
+StepperMotor motor_x(STEP_PIN_X, DIR_PIN_X, 1000, MS_PIN_X); // 1000 µs between HIGH and LOW pulses
+StepperMotor motor_y(STEP_PIN_Y, DIR_PIN_Y, 1000, MS_PIN_Y);
+StepperMotor motor_z(STEP_PIN_Z, DIR_PIN_Z, 1000, MS_PIN_Z);
+StepperMotor motor_a(STEP_PIN_A, DIR_PIN_A, 1000, MS_PIN_A); // Plunger strokes use their liquid class speed
 
 // Map motors to mechanical components (linear motion abstractions)
 TimingBelt belt_x(motor_x);
@@ -46,8 +67,27 @@ Lift lift(lead_screw_lift, z_dir);
 SyringeSystem syringes(lead_screw_syringe, z_dir);
 
 // Assemble the robot controller
-// 10000 and 1000 are distances moved per robot.update() call (µm)
-Robot robot(xy_system, lift, syringes, 10000, 1000); // XY: 10000 µm/update, Lift: 1000 µm/update
+// 10000 and 1000 cap the distance moved per robot.update() call (µm); moves
+// go one motion slice (motion_slice_ms) at a time, which is shorter
+Robot robot(xy_system, lift, syringes, 10000, 1000); // XY: ≤ 10000 µm/update, Lift: ≤ 1000 µm/update
+
+// Buffers incoming serial lines (and watches for the real-time halt)
+SerialLineReader reader;
+
+// Queues replies and feeds them to Serial without blocking
+SerialReplyWriter writer;
+
+// Parsed command waiting until the robot can accept it (e.g. G-code queue full)
+Command pending;
+bool has_pending = false;
+
+// Lines behind the pending one already checked for a halt
+uint8_t checked_lines = 0;
+
+// Lines that halt the robot (plain HALT, M112 and unknown plain text)
+bool isHaltLine(const char* line) {
+  return commandFromStr(line).type == CommandType::HaltRobot;
+}
 
 void setup() {
   // Start serial for command input/output (from the host/server)
@@ -59,23 +99,61 @@ void setup() {
 }
 
 void loop() {
-  // Read and process one-line serial commands
-  if (Serial.available()) {
-    String line = Serial.readStringUntil('\n');
-    if (line != "") {
-      // Parse text command into structured command
-      Command cmd = commandFromStr(line);
-
-      // Update robot state machine and get optional log message
-      String fetched_command = robot.fetch(cmd);
-
-      // Reply back over serial (used by the server/UI for logging)
-      if (fetched_command != String("")) {
-        Serial.println(fetched_command);
-      }
+  // Collect serial input; a real-time halt bypasses everything buffered
+  if (reader.poll()) {
+    Command halt;
+    halt.type = CommandType::HaltRobot;
+    writer.send(robot.fetch(halt));
+
+    // The line that was waiting is dropped too (answered with the others)
+    if (has_pending) {
+      has_pending = false;
+      reader.countDropped();
+    }
+  }
+
+  char line[max_line_length + 1];
+
+  // A halt line does not wait behind a blocked one: the blocked line and
+  // everything before the halt are given up (and answered)
+  if (has_pending && writer.hasRoom() && reader.lines() > checked_lines) {
+    int8_t at = reader.findLine(checked_lines, isHaltLine);
+    checked_lines = reader.lines();
+    if (at >= 0) {
+      has_pending = false;
+      reader.dropLines(at);
+      writer.send(Reply(ReplyCode::LineDropped));
     }
   }
 
+  // Answer dropped lines (too long, or cut off by a real-time halt) in
+  // order, so character-counting senders get one reply per line
+  while (!has_pending && reader.dropped() > 0 && writer.hasRoom()) {
+    reader.acknowledgeDropped();
+    writer.send(Reply(ReplyCode::LineDropped));
+  }
+
+  // Read and parse one-line serial commands
+  if (!has_pending && reader.dropped() == 0 && reader.readLine(line, sizeof(line)) && line[0] != '\0') {
+    // Parse text command into structured command
+    pending = commandFromStr(line);
+    has_pending = true;
+    checked_lines = 0;
+  }
+
+  // Hand it over once the robot can take it and its reply has room
+  if (has_pending && writer.hasRoom() && robot.canAccept(pending)) {
+    has_pending = false;
+
+    // Update robot state machine and reply back over serial
+    // (used by the server/UI for logging)
+    writer.send(robot.fetch(pending));
+  }
+
   // Execute one incremental motion step depending on current robot state
-  robot.update();
+  // (and report completion of long-running actions such as MIX)
+  writer.send(robot.update());
+
+  // Top up the hardware TX buffer; it drains while the next update() blocks
+  writer.poll();
 }
@@ -1,6 +1,79 @@
 #include <Arduino.h>
 #include <stdio.h>
+#include <string.h>
 #include "command.h"
+#include "gcode.h"
+#include "liquid_class.h"
+
+// Length of the word starting at str (up to the next space)
+static uint8_t wordLength(const char* str) {
+    uint8_t n = 0;
+    while (str[n] != '\0' && str[n] != ' ') n++;
+    return n;
+}
+
+// True if the word starting at str is word
+static bool isWord(const char* str, const char* word) {
+    uint8_t n = wordLength(str);
+    return strncmp(str, word, n) == 0 && word[n] == '\0';
+}
+
+// Start of the index-th space separated word of args ("" if absent)
+static const char* wordAt(const char* args, int index) {
+    for (int i = 0; i < index; i++) {
+        args = strchr(args, ' ');
+        if (args == nullptr) return "";
+        args++;
+    }
+    return args;
+}
+
+// Return the index-th space separated integer of args, or fallback if absent
+static long argAt(const char* args, int index, long fallback) {
+    const char* arg = wordAt(args, index);
+    return (wordLength(arg) == 0) ? fallback : atol(arg);
+}
+
+// Copy the index-th word of args into name (liquid class name sized).
+// Returns false if it is too long.
+static bool nameAt(const char* args, int index, char* name) {
+    const char* word = wordAt(args, index);
+    uint8_t n = wordLength(word);
+    if (n > liquid_class_name_length) return false;
+    memcpy(name, word, n);
+    name[n] = '\0';
+    return true;
+}
+
+// Optional liquid class name at index of args.
+// liquid is -1 when absent; returns false for an unknown name.
+static bool liquidAt(const char* args, int index, int8_t& liquid) {
+    char name[liquid_class_name_length + 1];
+    liquid = -1;
+    if (!nameAt(args, index, name)) return false;
+    if (name[0] == '\0') return true;
+    liquid = findLiquidClass(name);
+    return liquid != -1;
+}
+
+// "LIQUID <name> <fields...>": fields left out keep the class's current
+// values (or the "default" class's, for a new name)
+static bool liquidFromArgs(const char* args, LiquidClass& lc) {
+    char name[liquid_class_name_length + 1];
+    if (!nameAt(args, 0, name) || name[0] == '\0') return false;
+
+    int index = findLiquidClass(name);
+    lc = liquidClass(index == -1 ? 0 : index);
+    strcpy(lc.name, name);
+
+    lc.aspirate_ul_per_s = argAt(args, 1, lc.aspirate_ul_per_s);
+    lc.dispense_ul_per_s = argAt(args, 2, lc.dispense_ul_per_s);
+    lc.accel_ul_per_s2 = argAt(args, 3, lc.accel_ul_per_s2);
+    lc.settle_ms = argAt(args, 4, lc.settle_ms);
+    lc.air_gap_ul = argAt(args, 5, lc.air_gap_ul);
+    lc.blowout_ul = argAt(args, 6, lc.blowout_ul);
+    return lc.aspirate_ul_per_s > 0 && lc.dispense_ul_per_s > 0;
+}
 
 // Convert a serial input string into a Command structure.
 // Expected formats:
@@ -11,44 +84,77 @@
 // Halt movement:
 //   "RELEASED"
 //
-// Pipette:
-//   "PULL <ticks>"
-//   "PUSH <ticks>"
+// Pipette (optionally with a liquid class, see liquid_class.h):
+//   "PULL <ticks> [<class>]"
+//   "PUSH <ticks> [<class>]"
+//
+// Mix (stroke ticks, cycles, optional flow in µl/s and Z travel in µm):
+//   "MIX <ticks> <cycles> [<ul_per_s>] [<z_um>] [<class>]"
+//
+// Liquid classes (flows in µl/s, accel in µl/s², settle in ms, air in µl):
+//   "LIQUID <class>"                 select the class used by default
+//   "LIQUID <class> <aspirate> [<dispense>] [<accel>] [<settle_ms>]
+//           [<air_gap_ul>] [<blowout_ul>]"   add or change a class
+// An air gap is drawn with the tip lifted out of the liquid, and the tip
+// stays there: every aspirate with one (e.g. the built-in "volatile")
+// ends 5 mm (air_retract_um) higher than it started, or at the top of
+// travel (Z = 0) if that is closer. Back-to-back PULLs climb by that much
+// each, so lower the tip before the next one (queued G-code moves go back
+// to their planned Z on their own).
+//
+// Deck model for safe-travel moves (µm, lift Z up is positive, see deck.h):
+//   "DECK <z_um>"                    lift Z at which the bare mount meets the deck
+//   "TIP <length_um>"                length of the mounted tip
+//   "LABWARE <slot> <x0_um> <y0_um> <x1_um> <y1_um> <height_um>"
+//                                    footprint corners and top above the deck
+//   "LABWARE <slot>"                 empty the slot
+//
+// Jog (velocity in µm/s): one start frame, then keepalive frames (K) while
+// held. Keepalives never start motion and are not answered.
+//   "JOG <X|Y|Z> <um_per_s>"
+//   "JOG <X|Y|Z> <um_per_s> K"
+//
+// G-code (see gcode.h):
+//   "G1 X10 Y5 F600", "M114", ...
 //
 // Any unknown command defaults to HaltRobot.
-Command commandFromStr(const String& line) {
-    int p = line.indexOf(' ');
+Command commandFromStr(const char* line) {
+    if (isGcode(line)) {
+        return commandFromGcode(line);
+    }
+
+    const char* args = strchr(line, ' ');
     Command cmd;
 
     // No space → simple movement or halt command
-    if (p == -1) {
-        const String& str = line;
+    if (args == nullptr) {
+        const char* str = line;
 
-        if (str == "X+") {
+        if (isWord(str, "X+")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Xp;
         }
-        else if (str == "X-") {
+        else if (isWord(str, "X-")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Xn;
         }
-        else if (str == "Y+") {
+        else if (isWord(str, "Y+")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Yp;
         }
-        else if (str == "Y-") {
+        else if (isWord(str, "Y-")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Yn;
         }
-        else if (str == "Z+") {
+        else if (isWord(str, "Z+")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Zp;
         }
-        else if (str == "Z-") {
+        else if (isWord(str, "Z-")) {
             cmd.type = CommandType::Move;
             cmd.move = MoveDirective::Zn;
         }
-        else if (str == "RELEASED") {
+        else if (isWord(str, "RELEASED")) {
             // Stop continuous movement
             cmd.type = CommandType::HaltMove;
         }
@@ -59,22 +165,88 @@ Command commandFromStr(const String& line) {
     }
     else {
         // Space found → pipette command with argument
-        const String& str = line.substring(0, p);
-        int ticks = line.substring(p + 1).toInt();
+        const char* str = line;
+        args++;
+        int ticks = atol(args);
 
-        if (str == "PULL") {
+        if (isWord(str, "PULL")) {
             cmd.type = CommandType::Pipette;
             cmd.pip = {
                 .dir = PipetteDirection::Pull,
                 .value = ticks,
+                .liquid = -1,
             };
+            if (!liquidAt(args, 1, cmd.pip.liquid)) cmd.type = CommandType::HaltRobot;
         }
-        else if (str == "PUSH") {
+        else if (isWord(str, "PUSH")) {
             cmd.type = CommandType::Pipette;
             cmd.pip = {
                 .dir = PipetteDirection::Push,
                 .value = ticks,
+                .liquid = -1,
             };
+            if (!liquidAt(args, 1, cmd.pip.liquid)) cmd.type = CommandType::HaltRobot;
+        }
+        else if (isWord(str, "MIX")) {
+            cmd.type = CommandType::Mix;
+            cmd.mix = {
+                .ticks = int(argAt(args, 0, 0)),
+                .cycles = int(argAt(args, 1, 1)),
+                .ul_per_s = argAt(args, 2, 0),
+                .z_um = argAt(args, 3, 0),
+                .liquid = -1,
+            };
+            if (!liquidAt(args, 4, cmd.mix.liquid)) cmd.type = CommandType::HaltRobot;
+        }
+        else if (isWord(str, "LIQUID")) {
+            if (strchr(args, ' ') == nullptr) {
+                // Name only → select
+                cmd.type = CommandType::SelectLiquid;
+                cmd.liquid_index = findLiquidClass(args);
+                if (cmd.liquid_index == -1) cmd.type = CommandType::HaltRobot;
+            }
+            else {
+                cmd.type = CommandType::DefineLiquid;
+                if (!liquidFromArgs(args, cmd.liquid)) cmd.type = CommandType::HaltRobot;
+            }
+        }
+        else if (isWord(str, "DECK") || isWord(str, "TIP")) {
+            cmd.type = isWord(str, "DECK") ? CommandType::DeckHeight : CommandType::TipLength;
+            cmd.deck_um = atol(args);
+        }
+        else if (isWord(str, "LABWARE")) {
+            long slot = atol(args);
+            cmd.type = CommandType::DefineLabware;
+            cmd.labware.slot = slot;
+            cmd.labware.lw = {
+                .x0 = argAt(args, 1, 0),
+                .y0 = argAt(args, 2, 0),
+                .x1 = argAt(args, 3, 0),
+                .y1 = argAt(args, 4, 0),
+                .height_um = argAt(args, 5, 0),
+            };
+            if (slot < 0 || slot >= deck_labware_count) {
+                cmd.type = CommandType::HaltRobot;
+            }
+        }
+        else if (isWord(str, "JOG")) {
+            // "JOG <axis> <velocity>"
+            cmd.type = CommandType::Jog;
+            cmd.jog.um_per_s = argAt(args, 1, 0);
+            cmd.jog.keepalive = isWord(wordAt(args, 2), "K");
+
+            if (isWord(args, "X")) {
+                cmd.jog.axis = JogAxis::X;
+            }
+            else if (isWord(args, "Y")) {
+                cmd.jog.axis = JogAxis::Y;
+            }
+            else if (isWord(args, "Z")) {
+                cmd.jog.axis = JogAxis::Z;
+            }
+            else {
+                cmd.type = CommandType::HaltRobot;
+            }
         }
         else {
             // Unknown formatted command → emergency halt
@@ -1,13 +1,34 @@
 #pragma once
 
 #include <Arduino.h>
+#include "liquid_class.h"
+#include "deck.h"
 
 // High-level command categories received from serial input
 enum class CommandType {
     Move,        // Continuous axis motion (X/Y/Z)
     Pipette,     // Syringe operation (pull/push)
+    Jog,         // Velocity-mode axis motion kept alive by repeated frames
+    Mix,         // Repeated aspirate/dispense run on the controller
+    DefineLiquid, // Add or replace a liquid class
+    SelectLiquid, // Liquid class used when a request names none
+    DeckHeight,  // Deck surface height of the deck model
+    TipLength,   // Length of the mounted tip
+    DefineLabware, // Replace a labware slot of the deck model
     HaltMove,    // Stop current movement only
     HaltRobot,   // Emergency stop / fallback
+
+    // G-code front-end (see gcode.h)
+    Linear,      // G0/G1 straight move (queued)
+    Hop,         // M703 safe-travel move over the deck model (queued)
+    Home,        // G28 return to origin (queued)
+    SetPosition, // G92 redefine current position (queued)
+    Dwell,       // G4 pause (queued)
+    Positioning, // G90/G91 absolute/relative distances
+    Report,      // M114 position report
+    Wait,        // M400 wait until the queue has drained
+    Nop,         // Comment / accepted no-op line
+    Rejected,    // Unsupported or malformed G-code line
 };
 
 // Axis movement directives
@@ -28,9 +49,66 @@ enum class PipetteDirection {
 
 // Pipette command payload
 // value represents number of ticks (converted upstream from ml)
+// liquid is a liquid class index (-1 = the selected class)
 struct PipetteDirective {
     PipetteDirection dir;
     int value;
+    int8_t liquid;
+};
+
+// Jog axis
+enum class JogAxis {
+    X,
+    Y,
+    Z,
+};
+
+// Jog command payload
+// um_per_s is the requested signed velocity (0 = ramp down and stop).
+// Every frame refreshes the deadman of a running jog, but only a start
+// frame (keepalive false) may set an idle axis in motion.
+struct JogDirective {
+    JogAxis axis;
+    long um_per_s;
+    bool keepalive;
+};
+
+// Mix command payload
+// ticks    : stroke volume in ticks (minimum_ml per tick)
+// cycles   : number of aspirate/dispense cycles
+// ul_per_s : plunger flow rate (0 = the liquid class's aspirate/dispense flow)
+// z_um     : lift travel down while aspirating / up while dispensing (0 = none)
+// liquid   : liquid class index (-1 = the selected class)
+struct MixDirective {
+    int ticks;
+    int cycles;
+    long ul_per_s;
+    long z_um;
+    int8_t liquid;
+};
+
+// Axis flags for G-code moves
+static constexpr uint8_t axis_x = 0x01;
+static constexpr uint8_t axis_y = 0x02;
+static constexpr uint8_t axis_z = 0x04;
+
+// G0/G1, G28 and G92 payload (distances in µm)
+// axes  : which of x/y/z were given on the line
+// feed  : path speed in µm/s (0 = keep the modal feed)
+// rapid : G0, travel at the rapid limits (robot.h)
+struct LinearDirective {
+    uint8_t axes;
+    bool rapid;
+    long x;
+    long y;
+    long z;
+    long feed;
+};
+
+// Labware slot payload (see deck.h)
+struct LabwareDirective {
+    uint8_t slot;
+    Labware lw;
 };
 
 // Unified command structure parsed from serial string.
@@ -40,8 +118,22 @@ struct Command {
     union {
         MoveDirective move;     // Used when type == Move
         PipetteDirective pip;   // Used when type == Pipette
+        JogDirective jog;       // Used when type == Jog
+        MixDirective mix;       // Used when type == Mix
+        LinearDirective lin;    // Used when type == Linear/Hop/Home/SetPosition
+        LiquidClass liquid;     // Used when type == DefineLiquid
+        int8_t liquid_index;    // Used when type == SelectLiquid
+        long deck_um;           // Used when type == DeckHeight/TipLength
+        LabwareDirective labware; // Used when type == DefineLabware
+        unsigned long dwell_ms; // Used when type == Dwell
+        bool relative;          // Used when type == Positioning
     };
+
+    // Set for G-code lines: the sender counts characters and expects
+    // exactly one "ok" (or "error") per line once it has been consumed.
+    bool ack = false;
 };
 
 // Parse a single-line serial command into a structured Command.
-Command commandFromStr(const String& line);
+// Lines starting with a G, M or N word are handed to the G-code front-end.
+Command commandFromStr(const char* line);
@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include "deck.h"
+
+DeckModel::DeckModel() {
+    known_ = false;
+    deck_z_um_ = 0;
+    tip_length_um_ = 0;
+    for (uint8_t i = 0; i < deck_labware_count; i++) {
+        labware_[i] = {0, 0, 0, 0, 0};
+    }
+}
+
+void DeckModel::setDeckZ(long z_um) {
+    deck_z_um_ = z_um;
+    known_ = true;
+}
+
+void DeckModel::setTipLength(long um) {
+    tip_length_um_ = um;
+}
+
+bool DeckModel::setLabware(uint8_t slot, const Labware& lw) {
+    if (slot >= deck_labware_count) return false;
+    labware_[slot] = lw;
+    return true;
+}
+
+long DeckModel::required(const Labware& lw) {
+    return deck_z_um_ + tip_length_um_ + lw.height_um + hop_clearance_um;
+}
+
+// Clip the path against one axis of the grown footprint (Liang-Barsky)
+static bool clipAxis(float p0, float d, float lo, float hi, float& t_in, float& t_out) {
+    if (d == 0.0f) return p0 >= lo && p0 <= hi;
+    float a = (lo - p0) / d;
+    float b = (hi - p0) / d;
+    if (a > b) {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    t_in = max(t_in, a);
+    t_out = min(t_out, b);
+    return t_in <= t_out;
+}
+
+bool DeckModel::overlap(const Labware& lw, long x0, long y0, long x1, long y1,
+                        float& t_in, float& t_out) {
+    if (lw.height_um <= 0) return false;
+    t_in = 0.0f;
+    t_out = 1.0f;
+    return clipAxis(x0, float(x1 - x0), min(lw.x0, lw.x1) - hop_margin_um, max(lw.x0, lw.x1) + hop_margin_um, t_in, t_out) &&
+           clipAxis(y0, float(y1 - y0), min(lw.y0, lw.y1) - hop_margin_um, max(lw.y0, lw.y1) + hop_margin_um, t_in, t_out);
+}
+
+long DeckModel::clearance(long x0, long y0, long x1, long y1, float fa, float fb) {
+    if (!known_) return 0;
+
+    // The bare deck, then every footprint the path crosses within [fa, fb]
+    long z = deck_z_um_ + tip_length_um_ + hop_clearance_um;
+    for (uint8_t i = 0; i < deck_labware_count; i++) {
+        float t_in, t_out;
+        if (overlap(labware_[i], x0, y0, x1, y1, t_in, t_out) && t_in <= fb && t_out >= fa) {
+            z = max(z, required(labware_[i]));
+        }
+    }
+    return z;
+}
+
+float DeckModel::reach(long x0, long y0, long x1, long y1, float fa, float fb, long z) {
+    float f = fb;
+    for (uint8_t i = 0; i < deck_labware_count; i++) {
+        float t_in, t_out;
+        if (!overlap(labware_[i], x0, y0, x1, y1, t_in, t_out)) continue;
+        if (required(labware_[i]) <= z || t_out < fa) continue;
+
+        // Too low for this footprint: stop at its edge (or stay, if inside)
+        f = min(f, max(t_in, fa));
+    }
+    return f;
+}
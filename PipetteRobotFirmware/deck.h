@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Number of labware footprints in the deck model
+static constexpr uint8_t deck_labware_count = 8;
+
+// Safe-travel margins (µm)
+// hop_clearance_um : tip end kept this far above every labware top
+// hop_margin_um    : footprints grown by this much on every side (tip width,
+//                    belt play)
+static constexpr long hop_clearance_um = 2000;
+static constexpr long hop_margin_um = 3000;
+
+// Labware footprint (two opposite XY corners) and top height above the
+// deck surface, all in µm. height_um <= 0 marks an empty slot.
+struct Labware {
+    long x0;
+    long y0;
+    long x1;
+    long y1;
+    long height_um;
+};
+
+// Deck height model used to plan safe-travel moves (M703).
+// Heights are returned as lift Z coordinates (µm, up is positive, Z = 0 is
+// the top of travel).
+class DeckModel {
+public:
+    DeckModel();
+
+    // Lift Z at which the bare tip mount would touch the deck surface.
+    // Until it is set, every height query answers Z = 0.
+    void setDeckZ(long z_um);
+
+    // Length of the mounted tip below the mount (µm)
+    void setTipLength(long um);
+
+    // Replace a labware slot; false if slot is out of range
+    bool setLabware(uint8_t slot, const Labware& lw);
+
+    // Lowest lift Z keeping the tip clear of everything below the part
+    // [fa, fb] of the straight XY path (x0, y0) → (x1, y1). Above Z = 0
+    // (the top of travel) if something there is too tall to clear.
+    long clearance(long x0, long y0, long x1, long y1, float fa, float fb);
+
+    // Furthest point (fa ... fb) of that path the tip can reach from fa at
+    // lift Z z without entering a footprint it does not clear
+    float reach(long x0, long y0, long x1, long y1, float fa, float fb, long z);
+
+private:
+    bool known_;
+    long deck_z_um_;
+    long tip_length_um_;
+    Labware labware_[deck_labware_count];
+
+    // Lift Z clearing the top of lw
+    long required(const Labware& lw);
+
+    // Part [t_in, t_out] of the path above the grown footprint of lw;
+    // false if the path misses it
+    bool overlap(const Labware& lw, long x0, long y0, long x1, long y1,
+                 float& t_in, float& t_out);
+};
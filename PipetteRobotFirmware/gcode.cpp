@@ -0,0 +1,221 @@
+#include <Arduino.h>
+#include <ctype.h>
+#include "gcode.h"
+#include "command.h"
+#include "syringe_system.h"
+#include "liquid_class.h"
+
+// Words seen on one line (letter → value), only the ones we use
+struct GcodeWords {
+    bool has_g, has_m, has_x, has_y, has_z, has_f, has_p, has_s, has_v, has_l;
+    float g, m, x, y, z, f, p, s, v, l;
+};
+
+// mm → µm
+static long mmToUm(float mm) {
+    return lround(mm * 1000.0f);
+}
+
+// Read [+-]digits[.digits] and advance str.
+// (strtod would also accept exponents and hex, which breaks "G0X10".)
+static bool readNumber(const char*& str, float& out) {
+    const char* p = str;
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = (*p == '-');
+        p++;
+    }
+
+    long whole = 0;
+    long frac = 0;
+    long scale = 1;
+    bool digits = false;
+
+    while (isdigit(*p)) {
+        whole = whole * 10 + (*p - '0');
+        digits = true;
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (isdigit(*p)) {
+            // Further digits are below µm resolution
+            if (scale < 1000000L) {
+                frac = frac * 10 + (*p - '0');
+                scale *= 10;
+            }
+            digits = true;
+            p++;
+        }
+    }
+    if (!digits) return false;
+
+    out = float(whole) + float(frac) / float(scale);
+    if (negative) out = -out;
+    str = p;
+    return true;
+}
+
+// Split a line into letter/number words.
+// Returns false on a malformed word or an unknown letter.
+static bool parseWords(const char* str, GcodeWords& w) {
+    memset(&w, 0, sizeof(w));
+
+    while (*str != '\0') {
+        char c = toupper(*str);
+
+        // Whitespace, comments and checksum
+        if (c == ' ' || c == '\t' || c == '\r') {
+            str++;
+            continue;
+        }
+        if (c == ';' || c == '*') break;
+        if (c == '(') {
+            while (*str != '\0' && *str != ')') str++;
+            if (*str == ')') str++;
+            continue;
+        }
+
+        float value;
+        str++;
+        if (!readNumber(str, value)) return false;
+
+        switch (c) {
+            case 'N': break;  // Line number
+            case 'G': w.has_g = true; w.g = value; break;
+            case 'M': w.has_m = true; w.m = value; break;
+            case 'X': w.has_x = true; w.x = value; break;
+            case 'Y': w.has_y = true; w.y = value; break;
+            case 'Z': w.has_z = true; w.z = value; break;
+            case 'F': w.has_f = true; w.f = value; break;
+            case 'P': w.has_p = true; w.p = value; break;
+            case 'S': w.has_s = true; w.s = value; break;
+            case 'V': w.has_v = true; w.v = value; break;
+            case 'L': w.has_l = true; w.l = value; break;
+            default: return false;
+        }
+    }
+    return true;
+}
+
+// Liquid class from the L word (-1 = the selected class).
+// Returns false for an index outside the table.
+static bool readLiquid(const GcodeWords& w, int8_t& liquid) {
+    liquid = -1;
+    if (!w.has_l) return true;
+    // Only defined classes (the count never shrinks, so it stays valid in the queue)
+    if (w.l < 0 || w.l >= liquidClassCount()) return false;
+    liquid = int8_t(w.l);
+    return true;
+}
+
+// Copy X/Y/Z words into a LinearDirective
+static void readAxes(const GcodeWords& w, LinearDirective& lin) {
+    lin.axes = 0;
+    lin.x = lin.y = lin.z = 0;
+    if (w.has_x) { lin.axes |= axis_x; lin.x = mmToUm(w.x); }
+    if (w.has_y) { lin.axes |= axis_y; lin.y = mmToUm(w.y); }
+    if (w.has_z) { lin.axes |= axis_z; lin.z = mmToUm(w.z); }
+}
+
+bool isGcode(const char* line) {
+    char c = toupper(line[0]);
+    if (c == ';' || c == '(') return true;
+
+    // A G/M/N word is followed by a number ("MIX" is plain text)
+    if (c != 'G' && c != 'M' && c != 'N') return false;
+    int i = 1;
+    while (line[i] == ' ') i++;
+    return isdigit(line[i]) || line[i] == '-';
+}
+
+Command commandFromGcode(const char* line) {
+    Command cmd;
+    cmd.type = CommandType::Rejected;
+    cmd.ack = true;
+
+    GcodeWords w;
+    if (!parseWords(line, w)) return cmd;
+
+    // Comment-only or empty line
+    if (!w.has_g && !w.has_m) {
+        cmd.type = CommandType::Nop;
+        return cmd;
+    }
+
+    if (w.has_g && !w.has_m) {
+        int g = int(w.g);
+
+        if (g == 0 || g == 1) {
+            cmd.type = CommandType::Linear;
+            readAxes(w, cmd.lin);
+            cmd.lin.rapid = (g == 0);
+            // mm/min → µm/s
+            cmd.lin.feed = w.has_f ? lround(w.f * 1000.0f / 60.0f) : 0;
+            if (w.has_f && cmd.lin.feed <= 0) cmd.type = CommandType::Rejected;
+        }
+        else if (g == 4) {
+            cmd.type = CommandType::Dwell;
+            if (w.has_p) cmd.dwell_ms = lround(w.p);
+            else if (w.has_s) cmd.dwell_ms = lround(w.s * 1000.0f);
+            else cmd.dwell_ms = 0;
+        }
+        else if (g == 21) {
+            cmd.type = CommandType::Nop;
+        }
+        else if (g == 28) {
+            cmd.type = CommandType::Home;
+            readAxes(w, cmd.lin);
+            // No axis words → all axes
+            if (cmd.lin.axes == 0) cmd.lin.axes = axis_x | axis_y | axis_z;
+            cmd.lin.x = cmd.lin.y = cmd.lin.z = 0;
+            cmd.lin.rapid = true;
+            cmd.lin.feed = 0;
+        }
+        else if (g == 90 || g == 91) {
+            cmd.type = CommandType::Positioning;
+            cmd.relative = (g == 91);
+        }
+        else if (g == 92) {
+            cmd.type = CommandType::SetPosition;
+            readAxes(w, cmd.lin);
+            // No axis words → zero all axes
+            if (cmd.lin.axes == 0) cmd.lin.axes = axis_x | axis_y | axis_z;
+        }
+    }
+    else if (w.has_m && !w.has_g) {
+        int m = int(w.m);
+
+        if (m == 112) {
+            cmd.type = CommandType::HaltRobot;
+        }
+        else if (m == 114) {
+            cmd.type = CommandType::Report;
+        }
+        else if (m == 400) {
+            cmd.type = CommandType::Wait;
+        }
+        else if (m == 703) {
+            cmd.type = CommandType::Hop;
+            readAxes(w, cmd.lin);
+            cmd.lin.rapid = true;
+            cmd.lin.feed = 0;
+        }
+        else if (m == 701 && w.has_v) {
+            // ml → ticks (same discretization as the GUI)
+            cmd.type = CommandType::Pipette;
+            cmd.pip.dir = PipetteDirection::Pull;
+            cmd.pip.value = lround(w.v / minimum_ml);
+            if (!readLiquid(w, cmd.pip.liquid)) cmd.type = CommandType::Rejected;
+        }
+        else if (m == 702) {
+            // -1 is the "push all" request
+            cmd.type = CommandType::Pipette;
+            cmd.pip.dir = PipetteDirection::Push;
+            cmd.pip.value = w.has_v ? lround(w.v / minimum_ml) : -1;
+            if (!readLiquid(w, cmd.pip.liquid)) cmd.type = CommandType::Rejected;
+        }
+    }
+
+    return cmd;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include "command.h"
+
+// G-code subset accepted alongside the plain-text command grammar.
+// Distances are in mm, feed rates in mm/min, volumes in ml.
+//
+// Motion (queued, executed in order):
+//   G0 [X] [Y] [Z]        rapid move (full steps, see robot.h)
+//   G1 [X] [Y] [Z] [F]    straight move at feed F (modal)
+//   G4 P<ms> | S<s>       dwell
+//   G28 [X] [Y] [Z]       return to origin (Z first, then XY)
+//   G92 [X] [Y] [Z]       redefine the current position
+//   M703 [X] [Y] [Z]      safe-travel move at the rapid limits: the tip
+//                         rises only as high as the deck model (DECK, TIP,
+//                         LABWARE) requires along the way. A path over
+//                         labware too tall to clear even at Z = 0 is
+//                         answered "error: hop path too tall to clear"
+//                         (or, if the deck changed after it was queued,
+//                         cancels the queue with "#Hop too tall, queue
+//                         cleared")
+//
+// Modes:
+//   G90 / G91             absolute / relative distances
+//   G21                   millimetres (the only supported unit)
+//
+// Syringes (queued, L = liquid class index, default the selected class;
+// an index with no class defined is answered "error: unsupported command").
+// Volumes are checked against the syringe contents planned at the end of
+// the queue; a request that would not fit (or push more than is held) is
+// answered "error: syringe volume out of range" and not queued.
+//   M701 V<ml> [L]        aspirate
+//   M702 [V<ml>] [L]      dispense (all when V is omitted)
+//
+// Other:
+//   M112                  emergency halt
+//   M114                  report position ("X:.. Y:.. Z:.. V:..")
+//   M400                  wait until all queued moves are done
+//
+// N<line> prefixes, *<checksum> suffixes, ';' and '(...)' comments are
+// ignored. Every G-code line is answered with "ok" or "error: ..." when
+// it leaves the receive buffer, so senders can use character-counting
+// flow control against rx_buffer_size (see serial_line_reader.h).
+// Lines longer than max_line_length, and lines still buffered when the
+// real-time character '!' halts the robot, are answered
+// "error: line dropped" instead (see SerialLineReader). So is a line
+// waiting on a full queue or M400 when a halt line arrives behind it.
+
+// True if the line should be parsed as G-code
+// (starts with a G, M or N word, or is a comment)
+bool isGcode(const char* line);
+
+// Parse one G-code line into a Command (cmd.ack is always set)
+Command commandFromGcode(const char* line);
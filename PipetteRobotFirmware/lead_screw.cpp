@@ -3,17 +3,44 @@
 #include "stepper_motor.h"
 
 // Store motor reference (no ownership)
-LeadScrew::LeadScrew(StepperMotor& motor) : motor_(motor) {}
+LeadScrew::LeadScrew(StepperMotor& motor) : motor_(motor), um_(0) {}
 
 // Convert requested linear displacement (µm) into motor steps
-// and forward to the stepper motor
+// and forward to the stepper motor.
+// The target is rounded down to a whole step of the current size; the
+// fraction is picked up by the next move.
 void LeadScrew::move(long um) {
-    int n = umToStep(um);
-    motor_.moveSteps(n);
+    um_ += um;
+    long step = fine_microsteps / motor_.microsteps();
+    long target = umToPosition(um_) / step * step;
+    motor_.moveSteps((target - motor_.position()) / step);
 }
 
-// steps = distance / (µm per step)
-// Note: fractional steps are truncated (integer division).
-int LeadScrew::umToStep(long um) {
-    return um / um_per_step_;
+// One step = two pulse widths, so half period = (µm/step) / (2 · µm/s)
+void LeadScrew::setSpeed(long um_per_s) {
+    if (um_per_s <= 0) return;
+    bool fine = um_per_s * fine_microsteps <= max_fine_step_rate * um_per_step_;
+    bool was_fine = motor_.microsteps() == fine_microsteps;
+    motor_.setMicrosteps(fine ? fine_microsteps : 1);
+
+    long us = um_per_step_ * 500000L / (um_per_s * motor_.microsteps());
+    motor_.setPulseWidth(constrain(us, 1L, max_pulse_width_us));
+
+    // Back from full steps: move the fraction of a step they left over
+    if (fine && !was_fine) move(0);
+}
+
+// The default pulse width is given in full steps
+void LeadScrew::resetSpeed() {
+    setSpeed(defaultSpeed());
+}
+
+long LeadScrew::defaultSpeed() {
+    return um_per_step_ * 500000L / motor_.defaultPulseWidth();
+}
+
+// position = distance / (µm per step) · microsteps
+// Note: fractional microsteps are truncated.
+long LeadScrew::umToPosition(long um) {
+    return um * fine_microsteps / um_per_step_;
 }
@@ -5,17 +5,37 @@
 // Store mechanical reference and axis configuration
 Lift::Lift(LeadScrew& lead_screw, AxisDirection z_dir)
     : lead_screw_(lead_screw),
-      z_dir_(z_dir) {}
+      z_dir_(z_dir),
+      z_um_(0) {}
 
 // Move in logical +Z direction (Top)
 // Apply direction correction before passing to lead screw
 void Lift::moveTop(long um) {
+    z_um_ += um;
     um = static_cast<long>(z_dir_) * um;
     lead_screw_.move(um);
 }
 
 // Move in logical -Z direction (Bottom)
 void Lift::moveBottom(long um) {
+    z_um_ -= um;
     um = -static_cast<long>(z_dir_) * um;
     lead_screw_.move(um);
 }
+
+long Lift::getZ() {
+    return z_um_;
+}
+
+// Redefine the current height (no motion)
+void Lift::setPosition(long z_um) {
+    z_um_ = z_um;
+}
+
+void Lift::setSpeed(long um_per_s) {
+    lead_screw_.setSpeed(um_per_s);
+}
+
+void Lift::resetSpeed() {
+    lead_screw_.resetSpeed();
+}
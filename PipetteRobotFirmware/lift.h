@@ -18,9 +18,20 @@ public:
     // Move in logical -Z direction (distance in µm)
     void moveBottom(long um);
 
+    // Logical height (µm, +Z up) relative to the power-on / G92 origin
+    long getZ();
+    void setPosition(long z_um);
+
+    // Lift speed for following moves (µm/s), or back to default
+    void setSpeed(long um_per_s);
+    void resetSpeed();
+
 private:
     LeadScrew& lead_screw_;
 
     // Used to compensate for wiring/mechanical inversion
     AxisDirection z_dir_;
+
+    // Commanded logical height (µm)
+    long z_um_;
 };
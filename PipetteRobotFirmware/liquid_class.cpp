@@ -0,0 +1,39 @@
+#include <Arduino.h>
+#include <string.h>
+#include "liquid_class.h"
+
+// Built-in classes; the remaining slots are filled by defineLiquidClass().
+// "default" reproduces the lead screw's default pulse width (5 mm/s).
+static LiquidClass classes[liquid_class_count] = {
+    // name        aspirate  dispense  accel  settle  air gap  blowout
+    {"default",    584,      584,      0,     0,      0,       0},
+    {"water",      2000,     2000,     8000,  100,    0,       0},
+    {"viscous",    100,      50,       200,   1500,   0,       100},
+    {"volatile",   1000,     1000,     4000,  0,      50,      0},
+};
+static uint8_t class_count = 4;
+
+int findLiquidClass(const char* name) {
+    for (uint8_t i = 0; i < class_count; i++) {
+        if (strcmp(classes[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+const LiquidClass& liquidClass(uint8_t index) {
+    return classes[index < class_count ? index : 0];
+}
+
+uint8_t liquidClassCount() {
+    return class_count;
+}
+
+int defineLiquidClass(const LiquidClass& lc) {
+    int index = findLiquidClass(lc.name);
+    if (index == -1) {
+        if (class_count == liquid_class_count) return -1;
+        index = class_count++;
+    }
+    classes[index] = lc;
+    return index;
+}
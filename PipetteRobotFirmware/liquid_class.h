@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Liquid class table size and name length (characters, without the terminator)
+static constexpr uint8_t liquid_class_count = 6;
+static constexpr uint8_t liquid_class_name_length = 8;
+
+// Plunger profile for one kind of liquid (volumes in µl, rates in µl/s).
+// aspirate_ul_per_s : flow while pulling
+// dispense_ul_per_s : flow while pushing
+// accel_ul_per_s2   : ramp at both ends of a stroke (0 = start at full flow)
+// settle_ms         : wait after a stroke until the liquid column is at rest
+// air_gap_ul        : air drawn on top of an aspirated volume (tip lifted
+//                     out of the liquid first, and left there); pushed
+//                     out ahead of it
+// blowout_ul        : air drawn before the first aspiration into an empty
+//                     syringe; pushed out last, clearing the tip
+struct LiquidClass {
+    char name[liquid_class_name_length + 1];
+    long aspirate_ul_per_s;
+    long dispense_ul_per_s;
+    long accel_ul_per_s2;
+    unsigned int settle_ms;
+    unsigned int air_gap_ul;
+    unsigned int blowout_ul;
+};
+
+// The table lives in RAM and starts with the built-in classes
+// ("default" = the original fixed plunger speed, "water", "viscous",
+// "volatile") at every power-up.
+
+// Index of the class called name, or -1
+int findLiquidClass(const char* name);
+
+// Class at index (0 ... liquidClassCount() - 1, "default" is 0)
+const LiquidClass& liquidClass(uint8_t index);
+
+// Number of classes defined so far (built-ins included); it never shrinks
+uint8_t liquidClassCount();
+
+// Replace the class with the same name or add a new one.
+// Returns its index, or -1 if the table is full.
+int defineLiquidClass(const LiquidClass& lc);
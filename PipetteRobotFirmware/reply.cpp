@@ -0,0 +1,144 @@
+#include <Arduino.h>
+#include <string.h>
+#include "reply.h"
+
+// Message table in flash. Fields:
+//   %d  integer
+//   %c  character
+//   %1  fixed point, one decimal  (0.1 units, e.g. ml)
+//   %3  fixed point, three decimals (0.001 units, e.g. µm → mm)
+//   %s  Reply::text
+static const char msg_none[] PROGMEM = "";
+static const char msg_unsupported[] PROGMEM = "error: unsupported command";
+static const char msg_syringe_range[] PROGMEM = "error: syringe volume out of range";
+static const char msg_line_dropped[] PROGMEM = "error: line dropped";
+static const char msg_hop_too_tall[] PROGMEM = "error: hop path too tall to clear";
+static const char msg_halt_robot[] PROGMEM = "Halt Robot";
+static const char msg_halt_move[] PROGMEM = "Halt Move";
+static const char msg_move[] PROGMEM = "Move %c%c";
+static const char msg_jog[] PROGMEM = "Jog %c";
+static const char msg_stop_jog[] PROGMEM = "Stop Jog";
+static const char msg_pull[] PROGMEM = "Pull %1 ml";
+static const char msg_push[] PROGMEM = "Push %1 ml";
+static const char msg_push_all[] PROGMEM = "Push All";
+static const char msg_pull_rejected[] PROGMEM = "Pull request rejected";
+static const char msg_push_rejected[] PROGMEM = "Push request rejected";
+static const char msg_mix[] PROGMEM = "Mix %1 ml x%d";
+static const char msg_mix_rejected[] PROGMEM = "Mix request rejected";
+static const char msg_mix_done[] PROGMEM = "#Mix done";
+static const char msg_hop_cancelled[] PROGMEM = "#Hop too tall, queue cleared";
+static const char msg_liquid[] PROGMEM = "Liquid %s";
+static const char msg_liquid_set[] PROGMEM = "Liquid %s set";
+static const char msg_liquid_rejected[] PROGMEM = "Liquid %s rejected (table full)";
+static const char msg_deck_set[] PROGMEM = "Deck set";
+static const char msg_tip_set[] PROGMEM = "Tip set";
+static const char msg_labware_set[] PROGMEM = "Labware %d set";
+static const char msg_labware_cleared[] PROGMEM = "Labware %d cleared";
+static const char msg_position[] PROGMEM = "X:%3 Y:%3 Z:%3 V:%1";
+
+// Indexed by ReplyCode
+static const char* const messages[] PROGMEM = {
+    msg_none,
+    msg_unsupported,
+    msg_syringe_range,
+    msg_line_dropped,
+    msg_hop_too_tall,
+    msg_halt_robot,
+    msg_halt_move,
+    msg_move,
+    msg_jog,
+    msg_stop_jog,
+    msg_pull,
+    msg_push,
+    msg_push_all,
+    msg_pull_rejected,
+    msg_push_rejected,
+    msg_mix,
+    msg_mix_rejected,
+    msg_mix_done,
+    msg_hop_cancelled,
+    msg_liquid,
+    msg_liquid_set,
+    msg_liquid_rejected,
+    msg_deck_set,
+    msg_tip_set,
+    msg_labware_set,
+    msg_labware_cleared,
+    msg_position,
+};
+
+Reply::Reply(ReplyCode code, long a, long b) : code(code), ok(false) {
+    args[0] = a;
+    args[1] = b;
+    args[2] = 0;
+    args[3] = 0;
+    text[0] = '\0';
+}
+
+void Reply::setText(const char* name) {
+    strncpy(text, name, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+}
+
+bool Reply::empty() const {
+    return code == ReplyCode::None && !ok;
+}
+
+bool isEvent(ReplyCode code) {
+    const char* fmt = (const char*)pgm_read_ptr(&messages[uint8_t(code)]);
+    return pgm_read_byte(fmt) == '#';
+}
+
+// Append value with decimals fractional digits ("-12.345"); returns the
+// new length
+static uint8_t appendNumber(char* out, uint8_t n, uint8_t size, long value, uint8_t decimals) {
+    char digits[12];
+    uint8_t count = 0;
+    bool negative = value < 0;
+    unsigned long v = negative ? 0UL - (unsigned long)value : (unsigned long)value;
+
+    // Digits in reverse, at least one before the decimal point
+    do {
+        digits[count++] = '0' + (v % 10);
+        v /= 10;
+    } while (v > 0 || count <= decimals);
+
+    if (negative && n + 1 < size) out[n++] = '-';
+    while (count > 0 && n + 1 < size) {
+        if (count == decimals) {
+            out[n++] = '.';
+            if (n + 1 >= size) break;
+        }
+        out[n++] = digits[--count];
+    }
+    return n;
+}
+
+uint8_t formatReply(const Reply& reply, char* out, uint8_t size) {
+    const char* fmt = (const char*)pgm_read_ptr(&messages[uint8_t(reply.code)]);
+    uint8_t n = 0;
+    uint8_t arg = 0;
+
+    for (char c = pgm_read_byte(fmt); c != '\0' && n + 1 < size; c = pgm_read_byte(++fmt)) {
+        if (c != '%') {
+            out[n++] = c;
+            continue;
+        }
+
+        char field = pgm_read_byte(++fmt);
+        long value = (arg < 4) ? reply.args[arg] : 0;
+        if (field == 's') {
+            for (const char* t = reply.text; *t != '\0' && n + 1 < size; t++) out[n++] = *t;
+            continue;
+        }
+        arg++;
+
+        if (field == 'c') out[n++] = char(value);
+        else if (field == '1') n = appendNumber(out, n, size, value, 1);
+        else if (field == '3') n = appendNumber(out, n, size, value, 3);
+        else n = appendNumber(out, n, size, value, 0);
+    }
+
+    out[n] = '\0';
+    return n;
+}
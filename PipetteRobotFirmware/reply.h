@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include "liquid_class.h"
+
+// Longest formatted reply line (without the line end)
+static constexpr uint8_t max_reply_line = 48;
+
+// Everything the firmware sends back, as a code into the message table
+// (reply.cpp). Fields of a message are filled from Reply::args in order.
+// Events (sent by update() when a long action ends, not in answer to a
+// line) start with '#', so hosts never take them for the reply they wait for.
+enum class ReplyCode : uint8_t {
+    None,           // Nothing to send
+    Unsupported,    // "error: unsupported command"
+    SyringeRange,   // "error: syringe volume out of range"
+    LineDropped,    // "error: line dropped"
+    HopTooTall,     // "error: hop path too tall to clear"
+    HaltRobot,      // "Halt Robot"
+    HaltMove,       // "Halt Move"
+    Move,           // "Move <axis><sign>"
+    Jog,            // "Jog <axis>"
+    StopJog,        // "Stop Jog"
+    Pull,           // "Pull <ml> ml"
+    Push,           // "Push <ml> ml"
+    PushAll,        // "Push All"
+    PullRejected,   // "Pull request rejected"
+    PushRejected,   // "Push request rejected"
+    Mix,            // "Mix <ml> ml x<cycles>"
+    MixRejected,    // "Mix request rejected"
+    MixDone,        // "#Mix done"                 (event)
+    HopCancelled,   // "#Hop too tall, queue cleared" (event)
+    Liquid,         // "Liquid <name>"
+    LiquidSet,      // "Liquid <name> set"
+    LiquidRejected, // "Liquid <name> rejected (table full)"
+    DeckSet,        // "Deck set"
+    TipSet,         // "Tip set"
+    LabwareSet,     // "Labware <slot> set"
+    LabwareCleared, // "Labware <slot> cleared"
+    Position,       // "X:<mm> Y:<mm> Z:<mm> V:<ml>"
+};
+
+// One reply: a message code, its numbers and an optional name.
+// ok adds the "ok" line that closes every G-code line.
+// Volumes are passed in 0.1 ml, positions in µm.
+struct Reply {
+    ReplyCode code;
+    bool ok;
+    long args[4];
+    char text[liquid_class_name_length + 1];
+
+    explicit Reply(ReplyCode code = ReplyCode::None, long a = 0, long b = 0);
+
+    // Copy a name into text (truncated to fit)
+    void setText(const char* name);
+
+    // Nothing to send at all
+    bool empty() const;
+};
+
+// Events: messages starting with '#'
+bool isEvent(ReplyCode code);
+
+// Write the message line of reply into out (NUL-terminated, no line end).
+// Returns its length.
+uint8_t formatReply(const Reply& reply, char* out, uint8_t size);
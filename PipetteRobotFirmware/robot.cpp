@@ -2,6 +2,13 @@
 #include "robot.h"
 #include "command.h"
 #include "syringe_system.h"
+#include "liquid_class.h"
+#include "reply.h"
+
+// ticks → 0.1 ml for replies
+static long tenthsOfMl(int ticks) {
+    return lround(float(ticks) * minimum_ml * 10.0f);
+}
 
 // Construct robot controller and start in Halting state
 Robot::Robot(XYSystem& xy_system, Lift& lift, SyringeSystem& syringe_system,
@@ -12,15 +19,73 @@ Robot::Robot(XYSystem& xy_system, Lift& lift, SyringeSystem& syringe_system,
     // Default safe state (no motion)
     state_.type = WorkingType::Halting;
     state_.dir = MovingDirection::None;
+
+    jog_axis_ = JogAxis::X;
+    jog_velocity_ = 0;
+    jog_target_ = 0;
+    jog_keepalive_at_ = 0;
+
+    queue_head_ = 0;
+    queue_count_ = 0;
+    relative_ = false;
+    feed_um_per_s_ = 10000;  // 600 mm/min until the first F word
+    plan_x_ = plan_y_ = plan_z_ = 0;
+    plan_ticks_ = 0;
+    plan_air_gap_um_ = plan_blowout_um_ = 0;
+    traverse_length_ = traverse_done_ = traverse_step_ = 0;
+    dwell_until_ = 0;
+    hop_z_ = 0;
+    hop_f_ = hop_df_ = 0.0f;
+
+    mix_z_um_ = 0;
+    mix_z_start_ = 0;
+
+    active_liquid_ = 0;
+    pipette_phase_ = PipettePhase::Liquid;
+    pipette_pull_ = false;
+    pipette_liquid_ = 0;
+    pipette_ticks_ = 0;
+    pipette_blowout_um_ = pipette_air_gap_um_ = 0;
+    pipette_z_start_ = pipette_z_target_ = 0;
+    pipette_settle_until_ = 0;
 }
 
-void Robot::update() {
+Reply Robot::update() {
     // update() executes the current state machine action incrementally
-    if (state_.type == WorkingType::Halting) return;
+    if (state_.type == WorkingType::Halting) {
+        // Idle: start the next queued G-code command, if any
+        if (queue_count_ > 0) startQueued();
+        return Reply();
+    }
+
+    if (state_.type == WorkingType::Jogging) {
+        updateJog();
+        return Reply();
+    }
+
+    if (state_.type == WorkingType::Traversing) {
+        updateTraverse();
+        return Reply();
+    }
+
+    if (state_.type == WorkingType::Hopping) {
+        return updateHop();
+    }
+
+    if (state_.type == WorkingType::Mixing) {
+        return updateMix();
+    }
+
+    if (state_.type == WorkingType::Dwelling) {
+        if (long(millis() - dwell_until_) >= 0) {
+            state_.type = WorkingType::Halting;
+        }
+        return Reply();
+    }
 
     if (state_.type == WorkingType::Moving) {
         // Continuous move: repeat one small step every update() call
-        if (state_.dir == MovingDirection::None) return;
+        if (state_.dir == MovingDirection::None) return Reply();
         else if (state_.dir == MovingDirection::Xp) {
                 moveArmRight();
         }
@@ -41,37 +106,293 @@ void Robot::update() {
         }
     }
     else { // Pipetting
-        // Pipetting: advance one tick per update() call until completed
-        if (syringe_system_.getSyringeDirection() == SyringeDirection::None) {
-            // Auto-stop when syringe system finishes its queued ticks
-            state_.type = WorkingType::Halting;
-            state_.dir = MovingDirection::None;
-            return;
+        updatePipette();
+    }
+
+    return Reply();
+}
+
+void Robot::updateJog() {
+    // Deadman: missing keepalive → ramp down to zero
+    if (millis() - jog_keepalive_at_ > jog_keepalive_ms) {
+        jog_target_ = 0;
+    }
+
+    // Trapezoidal ramp: change velocity by at most accel · slice
+    long dv = jogAccel(jog_axis_) * motion_slice_ms / 1000;
+    if (jog_velocity_ < jog_target_) {
+        jog_velocity_ = min(jog_velocity_ + dv, jog_target_);
+    }
+    else if (jog_velocity_ > jog_target_) {
+        jog_velocity_ = max(jog_velocity_ - dv, jog_target_);
+    }
+
+    if (jog_velocity_ == 0 && jog_target_ == 0) {
+        halt();
+        return;
+    }
+
+    // Travel one slice at the current velocity; the stepping rate matches
+    // the velocity, so each slice takes about motion_slice_ms
+    long um = jog_velocity_ * motion_slice_ms / 1000;
+    long speed = abs(jog_velocity_);
+
+    if (jog_axis_ == JogAxis::X) {
+        xy_system_.setSpeed(speed);
+        xy_system_.moveRight(um);
+    }
+    else if (jog_axis_ == JogAxis::Y) {
+        xy_system_.setSpeed(speed);
+        xy_system_.moveUp(um);
+    }
+    else {
+        lift_.setSpeed(speed);
+        lift_.moveTop(um);
+    }
+}
+
+long Robot::jogMaxSpeed(JogAxis axis) {
+    return (axis == JogAxis::Z) ? lift_max_um_per_s : xy_max_um_per_s;
+}
+
+long Robot::jogAccel(JogAxis axis) {
+    return (axis == JogAxis::Z) ? lift_jog_accel_um_per_s2 : xy_jog_accel_um_per_s2;
+}
+
+void Robot::halt() {
+    state_.type = WorkingType::Halting;
+    state_.dir = MovingDirection::None;
+    syringe_system_.cancel();
+    jog_velocity_ = 0;
+    jog_target_ = 0;
+    xy_system_.resetSpeed();
+    lift_.resetSpeed();
+}
+
+bool Robot::idle() {
+    return state_.type == WorkingType::Halting && queue_count_ == 0;
+}
+
+void Robot::enqueue(const Command& cmd) {
+    uint8_t tail = (queue_head_ + queue_count_) % motion_queue_size;
+    queue_[tail] = cmd;
+    queue_count_++;
+}
+
+void Robot::startQueued() {
+    Command cmd = queue_[queue_head_];
+    queue_head_ = (queue_head_ + 1) % motion_queue_size;
+    queue_count_--;
+
+    if (cmd.type == CommandType::Linear) {
+        beginLinear(cmd.lin);
+    }
+    else if (cmd.type == CommandType::Hop) {
+        beginHop(cmd.lin);
+    }
+    else if (cmd.type == CommandType::Dwell) {
+        state_.type = WorkingType::Dwelling;
+        dwell_until_ = millis() + cmd.dwell_ms;
+    }
+    else if (cmd.type == CommandType::SetPosition) {
+        // All axes were filled in when the command was queued
+        xy_system_.setPosition(cmd.lin.x, cmd.lin.y);
+        lift_.setPosition(cmd.lin.z);
+    }
+    else if (cmd.type == CommandType::Pipette) {
+        // Streamed commands are answered by "ok" only; the log line is dropped
+        startPipette(cmd.pip);
+    }
+}
+
+void Robot::beginLinear(const LinearDirective& lin) {
+    from_x_ = xy_system_.getX();
+    from_y_ = xy_system_.getY();
+    from_z_ = lift_.getZ();
+    delta_x_ = lin.x - from_x_;
+    delta_y_ = lin.y - from_y_;
+    delta_z_ = lin.z - from_z_;
+
+    traverse_length_ = labs(delta_x_) + labs(delta_y_) + labs(delta_z_);
+    traverse_done_ = 0;
+    if (traverse_length_ == 0) return;
+
+    // Each axis steps at its own limit (a G0 lowering the tip keeps XY at
+    // the XY rapid); a feed slows both down to the same stepping speed
+    long xy_speed = lin.rapid ? xy_rapid_um_per_s : xy_max_um_per_s;
+    long lift_speed = lin.rapid ? lift_rapid_um_per_s : lift_max_um_per_s;
+    if (!lin.rapid) {
+        // Axes are stepped one after another within a slice, so each one has
+        // to run faster than the path speed by (|dx|+|dy|+|dz|) / path length
+        float path = sqrt(float(delta_x_) * delta_x_ +
+                          float(delta_y_) * delta_y_ +
+                          float(delta_z_) * delta_z_);
+        long speed = max(lround(float(lin.feed) * traverse_length_ / path), 1L);
+        xy_speed = min(xy_speed, speed);
+        lift_speed = min(lift_speed, speed);
+    }
+
+    // Advance per slice: the XY and Z parts of a slice take their own time,
+    // together motion_slice_ms
+    float ms = (labs(delta_x_) + labs(delta_y_)) * 1000.0f / xy_speed +
+               labs(delta_z_) * 1000.0f / lift_speed;
+    traverse_step_ = max(lround(traverse_length_ * motion_slice_ms / ms), 1L);
+
+    xy_system_.setSpeed(xy_speed);
+    lift_.setSpeed(lift_speed);
+    state_.type = WorkingType::Traversing;
+    state_.dir = MovingDirection::None;
+}
+
+void Robot::updateTraverse() {
+    // Advance one slice along the line, then step each axis to that point
+    traverse_done_ = min(traverse_done_ + traverse_step_, traverse_length_);
+
+    float f = float(traverse_done_) / float(traverse_length_);
+    long x = from_x_ + lround(delta_x_ * f);
+    long y = from_y_ + lround(delta_y_ * f);
+    long z = from_z_ + lround(delta_z_ * f);
+
+    xy_system_.moveRight(x - xy_system_.getX());
+    xy_system_.moveUp(y - xy_system_.getY());
+    lift_.moveTop(z - lift_.getZ());
+
+    if (traverse_done_ >= traverse_length_) {
+        halt();
+    }
+}
+
+void Robot::beginHop(const LinearDirective& lin) {
+    from_x_ = xy_system_.getX();
+    from_y_ = xy_system_.getY();
+    delta_x_ = lin.x - from_x_;
+    delta_y_ = lin.y - from_y_;
+    hop_z_ = lin.z;
+
+    float path = sqrt(float(delta_x_) * delta_x_ + float(delta_y_) * delta_y_);
+    hop_f_ = (path > 0.0f) ? 0.0f : 1.0f;
+    hop_df_ = (path > 0.0f) ? float(xy_rapid_um_per_s * motion_slice_ms / 1000) / path : 1.0f;
+
+    xy_system_.setSpeed(xy_rapid_um_per_s);
+    lift_.setSpeed(lift_rapid_um_per_s);
+    state_.type = WorkingType::Hopping;
+    state_.dir = MovingDirection::None;
+}
+
+Reply Robot::updateHop() {
+    long to_x = from_x_ + delta_x_;
+    long to_y = from_y_ + delta_y_;
+
+    // Lift toward the highest clearance still ahead: up while an obstacle
+    // is coming, down as soon as the tallest one is behind. Over the target
+    // the tip goes straight to the requested height.
+    long z_goal = hop_z_;
+    if (hop_f_ < 1.0f) {
+        long clear = deck_.clearance(from_x_, from_y_, to_x, to_y, hop_f_, 1.0f);
+
+        // Labware added after the hop was queued may be out of reach: stop
+        // (and drop what was queued after it) rather than fly through it
+        if (clear > 0) {
+            queue_count_ = 0;
+            halt();
+            return Reply(ReplyCode::HopCancelled);
         }
-        syringe_system_.advanceOneTick();
+        z_goal = max(z_goal, clear);
     }
+    long step = lift_rapid_um_per_s * motion_slice_ms / 1000;
+    lift_.moveTop(constrain(z_goal - lift_.getZ(), -step, step));
+
+    // XY as far as the tip clears at its new height (not at all while it
+    // is still inside the labware it started from)
+    if (hop_f_ < 1.0f) {
+        hop_f_ = deck_.reach(from_x_, from_y_, to_x, to_y, hop_f_,
+                             min(hop_f_ + hop_df_, 1.0f), lift_.getZ());
+        xy_system_.moveRight(from_x_ + lround(delta_x_ * hop_f_) - xy_system_.getX());
+        xy_system_.moveUp(from_y_ + lround(delta_y_ * hop_f_) - xy_system_.getY());
+    }
+
+    if (hop_f_ >= 1.0f && lift_.getZ() == hop_z_) {
+        halt();
+    }
+    return Reply();
+}
+
+void Robot::syncPlan() {
+    plan_x_ = xy_system_.getX();
+    plan_y_ = xy_system_.getY();
+    plan_z_ = lift_.getZ();
+    plan_ticks_ = syringe_system_.getCurrentPos();
+    plan_air_gap_um_ = syringe_system_.airGapHeld();
+    plan_blowout_um_ = syringe_system_.blowoutHeld();
+}
+
+bool Robot::planPipette(const PipetteDirective& pip) {
+    // Same rules as startPipette() and SyringeSystem::requestTicks()
+    if (pip.dir == PipetteDirection::Push) {
+        int ticks = (pip.value == -1) ? plan_ticks_ : pip.value;
+        if (ticks < 0 || ticks > plan_ticks_) return false;
+        plan_ticks_ -= ticks;
+        plan_air_gap_um_ = 0;
+        if (plan_ticks_ == 0) plan_blowout_um_ = 0;
+        return true;
+    }
+
+    const LiquidClass& lc = liquidClass(resolveLiquid(pip.liquid));
+    long blowout_um = 0;
+    if (plan_ticks_ == 0 && plan_blowout_um_ == 0) {
+        blowout_um = SyringeSystem::ulToUm(lc.blowout_ul);
+    }
+    long air_gap_um = SyringeSystem::ulToUm(lc.air_gap_ul);
+
+    long used = (long(plan_ticks_) + pip.value) * SyringeSystem::umPerTick() +
+                plan_air_gap_um_ + plan_blowout_um_ + blowout_um + air_gap_um;
+    if (pip.value < 0 || used > SyringeSystem::capacityUm()) return false;
+
+    plan_ticks_ += pip.value;
+    plan_air_gap_um_ += air_gap_um;
+    plan_blowout_um_ += blowout_um;
+    return true;
 }
 
-// XY movement helpers (distance is µm per call)
+Reply Robot::positionReport() {
+    Reply report(ReplyCode::Position, xy_system_.getX(), xy_system_.getY());
+    report.args[2] = lift_.getZ();
+    report.args[3] = tenthsOfMl(syringe_system_.getCurrentPos());
+    return report;
+}
+
+// XY movement helpers (one motion slice per call)
 void Robot::moveArmUp() {
-    xy_system_.moveUp(xy_um_per_move_);
+    xy_system_.moveUp(xyMoveSlice());
 }
 void Robot::moveArmDown() {
-    xy_system_.moveDown(xy_um_per_move_);
+    xy_system_.moveDown(xyMoveSlice());
 }
 void Robot::moveArmRight() {
-    xy_system_.moveRight(xy_um_per_move_);
+    xy_system_.moveRight(xyMoveSlice());
 }
 void Robot::moveArmLeft() {
-    xy_system_.moveLeft(xy_um_per_move_);
+    xy_system_.moveLeft(xyMoveSlice());
 }
 
-// Lift movement helpers (distance is µm per call)
+// Lift movement helpers (one motion slice per call)
 void Robot::moveLiftTop() {
-    lift_.moveTop(lift_um_per_move_);
+    lift_.moveTop(liftMoveSlice());
 }
 void Robot::moveLiftBottom() {
-    lift_.moveBottom(lift_um_per_move_);
+    lift_.moveBottom(liftMoveSlice());
+}
+
+// Continuous moves run at the maximum speed, a slice per update() so the
+// loop keeps serving the serial port; *_um_per_move_ caps the slice
+long Robot::xyMoveSlice() {
+    xy_system_.setSpeed(xy_max_um_per_s);
+    return min(xy_um_per_move_, xy_max_um_per_s * motion_slice_ms / 1000);
+}
+
+long Robot::liftMoveSlice() {
+    lift_.setSpeed(lift_max_um_per_s);
+    return min(lift_um_per_move_, lift_max_um_per_s * motion_slice_ms / 1000);
 }
 
 // Forward syringe requests to SyringeSystem
@@ -87,103 +408,434 @@ int Robot::getSyringeCurrentPos() {
     return syringe_system_.getCurrentPos();
 }
 
-String Robot::fetch(Command cmd) {
+Reply Robot::startPipette(PipetteDirective pip) {
+    state_.type = WorkingType::Pipetting;
+    state_.dir = MovingDirection::None;
+
+    pipette_pull_ = (pip.dir == PipetteDirection::Pull);
+    pipette_liquid_ = resolveLiquid(pip.liquid);
+    pipette_blowout_um_ = 0;
+    pipette_air_gap_um_ = 0;
+    pipette_phase_ = PipettePhase::Liquid;
+    setPipetteProfile(pipette_pull_);
+
+    const LiquidClass& lc = liquidClass(pipette_liquid_);
+
+    // ticks represent discrete volume units (minimum_ml per tick)
+    int ticks = pip.value;
+    pipette_ticks_ = ticks;
+
+    if (pipette_pull_) {
+        // Blowout air has to sit below the liquid, so only an empty
+        // syringe takes it
+        if (syringe_system_.getCurrentPos() == 0 && syringe_system_.blowoutHeld() == 0) {
+            pipette_blowout_um_ = SyringeSystem::ulToUm(lc.blowout_ul);
+        }
+        pipette_air_gap_um_ = SyringeSystem::ulToUm(lc.air_gap_ul);
+
+        bool accepted = ticks >= 0 &&
+            syringe_system_.hasRoom(ticks, pipette_blowout_um_ + pipette_air_gap_um_);
+        if (accepted) {
+            if (pipette_blowout_um_ > 0) {
+                // Raise, draw the blowout air, lower, then aspirate
+                raiseTip();
+            }
+            else {
+                // Queue pull ticks
+                accepted = syringe_system_.requestTicks(SyringeDirection::Pull, ticks);
+            }
+        }
+        if (!accepted) {
+            state_.type = WorkingType::Halting;
+            return Reply(ReplyCode::PullRejected);
+        }
+
+        return Reply(ReplyCode::Pull, tenthsOfMl(ticks));
+    }
+    else {
+        // Push: -1 is a special "push all" request
+        if (ticks == -1) {
+            syringe_system_.requestPushAll();
+            return Reply(ReplyCode::PushAll);
+        }
+
+        // Queue push ticks
+        bool accepted = syringe_system_.requestTicks(SyringeDirection::Push, ticks);
+        if (!accepted) {
+            state_.type = WorkingType::Halting;
+            return Reply(ReplyCode::PushRejected);
+        }
+
+        return Reply(ReplyCode::Push, tenthsOfMl(ticks));
+    }
+}
+
+void Robot::updatePipette() {
+    if (pipette_phase_ == PipettePhase::Raise || pipette_phase_ == PipettePhase::Lower) {
+        long step = lift_max_um_per_s * motion_slice_ms / 1000;
+        lift_.moveTop(constrain(pipette_z_target_ - lift_.getZ(), -step, step));
+        if (lift_.getZ() != pipette_z_target_) return;
+
+        if (pipette_phase_ == PipettePhase::Lower) {
+            syringe_system_.requestTicks(SyringeDirection::Pull, pipette_ticks_);
+            pipette_phase_ = PipettePhase::Liquid;
+        }
+        else {
+            // Blowout air before the liquid, or the air gap after it
+            bool blowout = pipette_blowout_um_ > 0;
+            syringe_system_.requestAir(blowout ? pipette_blowout_um_ : pipette_air_gap_um_, blowout);
+            pipette_phase_ = PipettePhase::DrawAir;
+        }
+        return;
+    }
+
+    syringe_system_.advance(motion_slice_ms);
+    if (syringe_system_.getSyringeDirection() != SyringeDirection::None) return;
+
+    if (pipette_phase_ == PipettePhase::DrawAir) {
+        if (pipette_blowout_um_ > 0) {
+            pipette_blowout_um_ = 0;
+            pipette_z_target_ = pipette_z_start_;
+            pipette_phase_ = PipettePhase::Lower;
+        }
+        else {
+            // Air gap drawn; the tip stays out of the liquid
+            halt();
+        }
+    }
+    else if (pipette_phase_ == PipettePhase::Liquid) {
+        pipette_settle_until_ = millis() + liquidClass(pipette_liquid_).settle_ms;
+        pipette_phase_ = PipettePhase::Settle;
+    }
+    else if (long(millis() - pipette_settle_until_) >= 0) {
+        // Auto-stop once the liquid has settled (and the air gap is drawn)
+        if (pipette_pull_ && pipette_air_gap_um_ > 0) {
+            raiseTip();
+        }
+        else {
+            halt();
+        }
+    }
+}
+
+void Robot::setPipetteProfile(bool pull) {
+    const LiquidClass& lc = liquidClass(pipette_liquid_);
+    long ul_per_s = pull ? lc.aspirate_ul_per_s : lc.dispense_ul_per_s;
+    syringe_system_.setProfile(SyringeSystem::ulToUm(ul_per_s),
+                               SyringeSystem::ulToUm(lc.accel_ul_per_s2));
+}
+
+void Robot::raiseTip() {
+    pipette_z_start_ = lift_.getZ();
+    // Never above the top of travel (Z = 0)
+    pipette_z_target_ = min(pipette_z_start_ + air_retract_um, 0L);
+    lift_.setSpeed(lift_max_um_per_s);
+    pipette_phase_ = PipettePhase::Raise;
+}
+
+uint8_t Robot::resolveLiquid(int8_t liquid) {
+    return (liquid < 0) ? active_liquid_ : uint8_t(liquid);
+}
+
+Reply Robot::startMix(MixDirective mix) {
+    // µl/s → plunger µm/s; without an explicit flow the liquid class sets
+    // the aspirate and dispense strokes apart
+    const LiquidClass& lc = liquidClass(resolveLiquid(mix.liquid));
+    long pull_ul_per_s = (mix.ul_per_s > 0) ? mix.ul_per_s : lc.aspirate_ul_per_s;
+    long push_ul_per_s = (mix.ul_per_s > 0) ? mix.ul_per_s : lc.dispense_ul_per_s;
+
+    if (!syringe_system_.requestMix(mix.ticks, mix.cycles,
+                                    SyringeSystem::ulToUm(pull_ul_per_s),
+                                    SyringeSystem::ulToUm(push_ul_per_s))) {
+        return Reply(ReplyCode::MixRejected);
+    }
+
+    state_.type = WorkingType::Mixing;
+    state_.dir = MovingDirection::None;
+    mix_z_um_ = mix.z_um;
+    mix_z_start_ = lift_.getZ();
+    if (mix_z_um_ != 0) lift_.setSpeed(lift_max_um_per_s);
+
+    return Reply(ReplyCode::Mix, tenthsOfMl(mix.ticks), mix.cycles);
+}
+
+Reply Robot::updateMix() {
+    long pos = syringe_system_.advanceMix(motion_slice_ms);
+
+    // Tip follows the liquid level: down while aspirating, up while dispensing
+    if (mix_z_um_ != 0) {
+        float f = float(pos) / float(syringe_system_.mixStroke());
+        long z = mix_z_start_ - lround(f * mix_z_um_);
+        lift_.moveTop(z - lift_.getZ());
+    }
+
+    if (!syringe_system_.isMixing()) {
+        halt();
+        return Reply(ReplyCode::MixDone);
+    }
+    return Reply();
+}
+
+bool Robot::canAccept(const Command& cmd) {
+    // Plain-text commands are always consumed (busy ones are ignored)
+    if (!cmd.ack) return true;
+
+    if (cmd.type == CommandType::Linear ||
+        cmd.type == CommandType::Hop ||
+        cmd.type == CommandType::SetPosition ||
+        cmd.type == CommandType::Dwell ||
+        cmd.type == CommandType::Pipette) {
+        return queue_count_ < motion_queue_size;
+    }
+    if (cmd.type == CommandType::Home) {
+        // Queued as two moves (Z, then XY)
+        return queue_count_ + 2 <= motion_queue_size;
+    }
+    if (cmd.type == CommandType::Wait) {
+        return idle();
+    }
+    return true;
+}
+
+Reply Robot::fetchGcode(const Command& cmd) {
+    // Moves made outside the queue (jogging, X+ ...) shift the planning origin
+    if (idle()) syncPlan();
+
+    Reply reply;
+
+    if (cmd.type == CommandType::Rejected) {
+        return Reply(ReplyCode::Unsupported);
+    }
+    else if (cmd.type == CommandType::HaltRobot) {
+        queue_count_ = 0;
+        halt();
+        reply.code = ReplyCode::HaltRobot;
+    }
+    else if (cmd.type == CommandType::Linear || cmd.type == CommandType::Hop) {
+        // Resolve to absolute coordinates against the end of the queue
+        Command queued = cmd;
+        LinearDirective& lin = queued.lin;
+        long x = (lin.axes & axis_x) ? (relative_ ? plan_x_ + lin.x : lin.x) : plan_x_;
+        long y = (lin.axes & axis_y) ? (relative_ ? plan_y_ + lin.y : lin.y) : plan_y_;
+        long z = (lin.axes & axis_z) ? (relative_ ? plan_z_ + lin.z : lin.z) : plan_z_;
+
+        // A hop never goes above the top of travel, so labware it cannot
+        // clear there rejects it (the planned position stays put)
+        if (cmd.type == CommandType::Hop &&
+            deck_.clearance(plan_x_, plan_y_, x, y, 0.0f, 1.0f) > 0) {
+            return Reply(ReplyCode::HopTooTall);
+        }
+
+        plan_x_ = x;
+        plan_y_ = y;
+        plan_z_ = z;
+        if (lin.feed > 0) feed_um_per_s_ = lin.feed;
+
+        lin.axes = axis_x | axis_y | axis_z;
+        lin.x = plan_x_;
+        lin.y = plan_y_;
+        lin.z = plan_z_;
+        lin.feed = feed_um_per_s_;
+        enqueue(queued);
+    }
+    else if (cmd.type == CommandType::Home) {
+        Command queued = cmd;
+        queued.type = CommandType::Linear;
+        LinearDirective& lin = queued.lin;
+        lin.axes = axis_x | axis_y | axis_z;
+
+        // Lift first so XY travel happens at the top
+        if (cmd.lin.axes & axis_z) {
+            plan_z_ = 0;
+            lin.x = plan_x_;
+            lin.y = plan_y_;
+            lin.z = plan_z_;
+            enqueue(queued);
+        }
+        if (cmd.lin.axes & (axis_x | axis_y)) {
+            if (cmd.lin.axes & axis_x) plan_x_ = 0;
+            if (cmd.lin.axes & axis_y) plan_y_ = 0;
+            lin.x = plan_x_;
+            lin.y = plan_y_;
+            lin.z = plan_z_;
+            enqueue(queued);
+        }
+    }
+    else if (cmd.type == CommandType::SetPosition) {
+        Command queued = cmd;
+        LinearDirective& lin = queued.lin;
+        if (lin.axes & axis_x) plan_x_ = lin.x;
+        if (lin.axes & axis_y) plan_y_ = lin.y;
+        if (lin.axes & axis_z) plan_z_ = lin.z;
+        lin.x = plan_x_;
+        lin.y = plan_y_;
+        lin.z = plan_z_;
+        enqueue(queued);
+    }
+    else if (cmd.type == CommandType::Pipette) {
+        // Answered now, so a batch sender learns about it before it
+        // dispenses volume that was never aspirated
+        if (!planPipette(cmd.pip)) return Reply(ReplyCode::SyringeRange);
+        enqueue(cmd);
+    }
+    else if (cmd.type == CommandType::Dwell) {
+        enqueue(cmd);
+    }
+    else if (cmd.type == CommandType::Positioning) {
+        relative_ = cmd.relative;
+    }
+    else if (cmd.type == CommandType::Report) {
+        reply = positionReport();
+    }
+    // Wait (canAccept() held it until idle) and Nop need no action
+
+    reply.ok = true;
+    return reply;
+}
+
+Reply Robot::fetch(const Command& cmd) {
     // fetch() updates the state machine based on a single command.
-    // New actions are accepted only when Halting, except halt commands.
-    String fetched_command = "";
+    // New actions are accepted only when idle, except halt commands.
+    if (cmd.ack) {
+        return fetchGcode(cmd);
+    }
+
+    Reply fetched_command;
 
     if (cmd.type == CommandType::HaltRobot) {
         // Global stop (also used as fallback for unknown commands)
-        state_.type = WorkingType::Halting;
-        state_.dir = MovingDirection::None;
-        fetched_command = "Halt Robot";
+        queue_count_ = 0;
+        halt();
+        fetched_command.code = ReplyCode::HaltRobot;
     }
     else if (cmd.type == CommandType::HaltMove) {
         // Stop continuous movement only
         if (state_.type == WorkingType::Moving) {
-            fetched_command = "Halt Move";
+            fetched_command.code = ReplyCode::HaltMove;
             state_.type = WorkingType::Halting;
             state_.dir = MovingDirection::None;
         }
+        else if (state_.type == WorkingType::Jogging) {
+            // Decelerate instead of stopping dead
+            fetched_command.code = ReplyCode::HaltMove;
+            jog_target_ = 0;
+        }
+    }
+    else if (cmd.type == CommandType::DefineLiquid) {
+        // Takes effect for requests started afterwards
+        bool full = defineLiquidClass(cmd.liquid) == -1;
+        fetched_command.code = full ? ReplyCode::LiquidRejected : ReplyCode::LiquidSet;
+        fetched_command.setText(cmd.liquid.name);
+    }
+    else if (cmd.type == CommandType::SelectLiquid) {
+        active_liquid_ = cmd.liquid_index;
+        fetched_command.code = ReplyCode::Liquid;
+        fetched_command.setText(liquidClass(active_liquid_).name);
+    }
+    else if (cmd.type == CommandType::DeckHeight) {
+        // Used by safe-travel moves planned afterwards
+        deck_.setDeckZ(cmd.deck_um);
+        fetched_command.code = ReplyCode::DeckSet;
+    }
+    else if (cmd.type == CommandType::TipLength) {
+        deck_.setTipLength(cmd.deck_um);
+        fetched_command.code = ReplyCode::TipSet;
+    }
+    else if (cmd.type == CommandType::DefineLabware) {
+        deck_.setLabware(cmd.labware.slot, cmd.labware.lw);
+        bool set = cmd.labware.lw.height_um > 0;
+        fetched_command = Reply(set ? ReplyCode::LabwareSet : ReplyCode::LabwareCleared, cmd.labware.slot);
+    }
+    else if (cmd.type == CommandType::Mix) {
+        // Runs entirely on the controller; "#Mix done" is sent by update()
+        if (idle()) {
+            fetched_command = startMix(cmd.mix);
+        }
+    }
+    else if (cmd.type == CommandType::Jog) {
+        long limit = jogMaxSpeed(cmd.jog.axis);
+        long target = constrain(cmd.jog.um_per_s, -limit, limit);
+
+        bool running = state_.type == WorkingType::Jogging && cmd.jog.axis == jog_axis_;
+
+        if (cmd.jog.keepalive) {
+            // Refresh the deadman and follow the new velocity, silently.
+            // Keepalives never start motion, and one arriving after a stop
+            // (deadman, RELEASED, stop frame) does not revive the jog.
+            if (running && jog_target_ != 0) {
+                jog_target_ = target;
+                jog_keepalive_at_ = millis();
+            }
+        }
+        else if (target == 0) {
+            // Stop frame: always answered, the axis may already be at rest
+            if (running) jog_target_ = 0;
+            fetched_command.code = ReplyCode::StopJog;
+        }
+        else if (idle() || running) {
+            // Start jogging from rest (or change velocity); update() ramps
+            // toward the target
+            if (!running) {
+                state_.type = WorkingType::Jogging;
+                state_.dir = MovingDirection::None;
+                jog_axis_ = cmd.jog.axis;
+                jog_velocity_ = 0;
+            }
+            jog_target_ = target;
+            jog_keepalive_at_ = millis();
+
+            fetched_command.code = ReplyCode::Jog;
+            if (jog_axis_ == JogAxis::X) fetched_command.args[0] = 'X';
+            else if (jog_axis_ == JogAxis::Y) fetched_command.args[0] = 'Y';
+            else fetched_command.args[0] = 'Z';
+        }
     }
     else if (cmd.type == CommandType::Move) {
         // Start continuous movement only when idle
-        if (state_.type == WorkingType::Halting) {
+        if (idle()) {
             state_.type = WorkingType::Moving;
-            fetched_command = "Move ";
+            fetched_command.code = ReplyCode::Move;
 
             // Map MoveDirective to internal MovingDirection
             if (cmd.move == MoveDirective::Xp) {
                 state_.dir = MovingDirection::Xp;
-                fetched_command += "X+";
+                fetched_command.args[0] = 'X';
+                fetched_command.args[1] = '+';
             }
             else if (cmd.move == MoveDirective::Xn) {
                 state_.dir = MovingDirection::Xn;
-                fetched_command += "X-";
+                fetched_command.args[0] = 'X';
+                fetched_command.args[1] = '-';
             }
             else if (cmd.move == MoveDirective::Yp) {
                 state_.dir = MovingDirection::Yp;
-                fetched_command += "Y+";
+                fetched_command.args[0] = 'Y';
+                fetched_command.args[1] = '+';
             }
             else if (cmd.move == MoveDirective::Yn) {
                 state_.dir = MovingDirection::Yn;
-                fetched_command += "Y-";
+                fetched_command.args[0] = 'Y';
+                fetched_command.args[1] = '-';
             }
             else if (cmd.move == MoveDirective::Zp) {
                 state_.dir = MovingDirection::Zp;
-                fetched_command += "Z+";
+                fetched_command.args[0] = 'Z';
+                fetched_command.args[1] = '+';
             }
             else if (cmd.move == MoveDirective::Zn) {
                 state_.dir = MovingDirection::Zn;
-                fetched_command += "Z-";
+                fetched_command.args[0] = 'Z';
+                fetched_command.args[1] = '-';
             }
         }
     }
     else if (cmd.type == CommandType::Pipette) {
         // Start pipetting only when idle
-        if (state_.type == WorkingType::Halting) {
-            state_.type = WorkingType::Pipetting;
-            state_.dir = MovingDirection::None;
-
-            // ticks represent discrete volume units (minimum_ml per tick)
-            int ticks = cmd.pip.value;
-
-            if (cmd.pip.dir == PipetteDirection::Pull) {
-                // Queue pull ticks
-                bool accepted = syringe_system_.requestTicks(SyringeDirection::Pull, ticks);
-                if (!accepted) {
-                    state_.type = WorkingType::Halting;
-                    return "Pull request rejected";
-                }
-
-                // Build log message in ml
-                fetched_command = "Pull ";
-                fetched_command += String(float(ticks) * minimum_ml, 1);
-                fetched_command += " ml";
-            }
-            else {
-                // Push: -1 is a special "push all" request
-                if (ticks == -1) {
-                    syringe_system_.requestPushAll();
-                    fetched_command = "Push All";
-                }
-                else {
-                    // Queue push ticks                    
-                    bool accepted = syringe_system_.requestTicks(SyringeDirection::Push, ticks);
-                    if (!accepted) {
-                        state_.type = WorkingType::Halting;
-                        return "Push request rejected";
-                    }
-
-                    // Build log message in ml
-                    fetched_command = "Push ";
-                    fetched_command += String(float(ticks) * minimum_ml, 1);
-                    fetched_command += " ml";
-                }
-            }
+        if (idle()) {
+            fetched_command = startPipette(cmd.pip);
         }
     }
 
-    // Empty string means "no message to send back"
+    // An empty reply means "no message to send back"
     return fetched_command;
 }
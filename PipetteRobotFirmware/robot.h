@@ -1,15 +1,47 @@
 #pragma once
 
-#include "WString.h"
 #include "xy_system.h"
 #include "lift.h"
 #include "syringe_system.h"
 #include "command.h"
+#include "deck.h"
+#include "reply.h"
+
+// Speed-controlled motion (jogging, G-code moves)
+// motion_slice_ms : travel time executed per update(), bounds how late a
+//                   new velocity, a stop or a serial line takes effect
+static constexpr long motion_slice_ms = 20;
+static constexpr long xy_max_um_per_s = 100000;    // 100 mm/s
+static constexpr long lift_max_um_per_s = 5000;    // 5 mm/s
+
+// G0 / G28 travel speed. Above max_fine_step_rate (stepper_motor.h), so the
+// drivers switch to full steps; slower moves keep fine microsteps.
+static constexpr long xy_rapid_um_per_s = 150000;  // 150 mm/s
+static constexpr long lift_rapid_um_per_s = 10000; // 10 mm/s
+
+// Velocity-mode jogging
+// jog_keepalive_ms : deadman; without a JOG frame for this long the axis
+//                    ramps down to a stop (worst case keepalive + max/accel)
+static constexpr unsigned long jog_keepalive_ms = 250;
+static constexpr long xy_jog_accel_um_per_s2 = 400000;    // 0 → max in 0.25 s
+static constexpr long lift_jog_accel_um_per_s2 = 20000;   // 0 → max in 0.25 s
+
+// Number of queued G-code commands (moves, dwells, syringe operations)
+static constexpr uint8_t motion_queue_size = 8;
+
+// Lift travel that takes the tip out of the liquid before air is drawn
+// (blowout air and air gaps of a liquid class)
+static constexpr long air_retract_um = 5000;
 
 // Top-level mode of operation (single active mode at a time)
 enum class WorkingType {
     Moving,     // Continuous motion (XY/Lift) driven by update()
-    Pipetting,  // Syringe ticks driven by update()
+    Pipetting,  // Syringe request (see PipettePhase) driven by update()
+    Jogging,    // Velocity-controlled motion with deadman keepalive
+    Traversing, // Queued straight move (G0/G1) driven by update()
+    Hopping,    // Queued safe-travel move (M703) driven by update()
+    Dwelling,   // Queued pause (G4)
+    Mixing,     // Oscillating plunger (MIX) driven by update()
     Halting,    // Idle / stopped (safe state)
 };
 
@@ -25,6 +57,15 @@ enum class MovingDirection {
     Zn,
 };
 
+// Steps of a syringe request while Pipetting
+enum class PipettePhase {
+    Raise,      // Tip up out of the liquid before drawing air
+    DrawAir,    // Blowout air (then Lower) or air gap (then done)
+    Lower,      // Tip back down into the liquid after the blowout air
+    Liquid,     // Aspirate / dispense stroke
+    Settle,     // Liquid class settle delay
+};
+
 // Internal controller state used by update()
 struct RobotState {
     WorkingType type;    // Current mode
@@ -36,24 +77,25 @@ struct RobotState {
 // - update() executes a small incremental motion every call
 class Robot {
 public:
-    // xy_um_per_move   : XY travel per update() call (µm)
-    // lift_um_per_move : Lift travel per update() call (µm)
+    // xy_um_per_move   : XY travel per update() call, at most (µm)
+    // lift_um_per_move : Lift travel per update() call, at most (µm)
     Robot(XYSystem& xy_system,
           Lift& lift,
           SyringeSystem& syringe_system,
           long xy_um_per_move,
           long lift_um_per_move);
 
-    // Periodic step (called continuously from loop())
-    void update();
+    // Periodic step (called continuously from loop()).
+    // Returns a message when a long-running action completes (else empty).
+    Reply update();
 
-    // XY motion primitives (one incremental move)
+    // XY motion primitives (one motion slice at xy_max_um_per_s)
     void moveArmUp();
     void moveArmDown();
     void moveArmRight();
     void moveArmLeft();
 
-    // Lift motion primitives (one incremental move)
+    // Lift motion primitives (one motion slice at lift_max_um_per_s)
     void moveLiftTop();
     void moveLiftBottom();
 
@@ -64,8 +106,12 @@ public:
     // Current syringe position in ticks
     int getSyringeCurrentPos();
 
-    // Consume a command and return a log string (empty if ignored)
-    String fetch(Command cmd);
+    // False while a command has to wait (e.g. G-code queue full, or M400
+    // with moves pending); the caller keeps it and retries later
+    bool canAccept(const Command& cmd);
+
+    // Consume a command and return its reply (empty if ignored)
+    Reply fetch(const Command& cmd);
 
 private:
     // Subsystem references (owned outside)
@@ -79,4 +125,123 @@ private:
 
     // Current controller state
     RobotState state_;
+
+    // Jog state (only meaningful in Jogging)
+    JogAxis jog_axis_;
+    long jog_velocity_;                // Current velocity (µm/s, signed)
+    long jog_target_;                  // Requested velocity (µm/s, signed)
+    unsigned long jog_keepalive_at_;   // millis() of the last JOG frame
+
+    // Ramp toward the requested velocity and move one slice
+    void updateJog();
+
+    // Per-axis jog limits
+    long jogMaxSpeed(JogAxis axis);
+    long jogAccel(JogAxis axis);
+
+    // Set the speed of a continuous move and return its travel per update()
+    long xyMoveSlice();
+    long liftMoveSlice();
+
+    // Stop all motion immediately and restore default axis speeds
+    void halt();
+
+    // Halting with nothing queued
+    bool idle();
+
+    // Liquid class used when a request names none
+    uint8_t active_liquid_;
+
+    // Syringe request in progress (only meaningful in Pipetting)
+    PipettePhase pipette_phase_;
+    bool pipette_pull_;
+    uint8_t pipette_liquid_;
+    int pipette_ticks_;
+    long pipette_blowout_um_;      // Blowout air still to draw
+    long pipette_air_gap_um_;      // Air gap to draw after the liquid
+    long pipette_z_start_;         // Height the tip was raised from
+    long pipette_z_target_;
+    unsigned long pipette_settle_until_;
+
+    // Start a syringe request; returns the log message
+    Reply startPipette(PipetteDirective pip);
+
+    // One slice of the syringe request
+    void updatePipette();
+
+    // Plunger speed and ramp of the request's liquid class
+    void setPipetteProfile(bool pull);
+
+    // Lift the tip by air_retract_um, at most to Z = 0 (Raise phase)
+    void raiseTip();
+
+    // Class index for a request (-1 = the selected class)
+    uint8_t resolveLiquid(int8_t liquid);
+
+    // Mixing: lift travel and the height it oscillates from
+    long mix_z_um_;
+    long mix_z_start_;
+
+    // Start a MIX request; returns the log message
+    Reply startMix(MixDirective mix);
+
+    // One slice of plunger (and optional lift) motion
+    Reply updateMix();
+
+    // G-code motion queue (ring buffer of pending commands)
+    Command queue_[motion_queue_size];
+    uint8_t queue_head_;
+    uint8_t queue_count_;
+
+    // G-code modal state and the position at the end of the queue
+    bool relative_;
+    long feed_um_per_s_;
+    long plan_x_;
+    long plan_y_;
+    long plan_z_;
+
+    // Syringe contents at the end of the queue (liquid ticks, air µm)
+    int plan_ticks_;
+    long plan_air_gap_um_;
+    long plan_blowout_um_;
+
+    // Book a queued syringe request against the planned contents.
+    // Returns false if the syringe would reject it when it runs.
+    bool planPipette(const PipetteDirective& pip);
+
+    // Straight move in progress (only meaningful in Traversing)
+    long from_x_, from_y_, from_z_;
+    long delta_x_, delta_y_, delta_z_;
+    long traverse_length_;   // |dx| + |dy| + |dz| (µm)
+    long traverse_done_;     // Part of traverse_length_ already travelled
+    long traverse_step_;     // Part of traverse_length_ covered per slice
+
+    // End of the dwell in progress (millis())
+    unsigned long dwell_until_;
+
+    void enqueue(const Command& cmd);
+    void startQueued();
+    void beginLinear(const LinearDirective& lin);
+    void updateTraverse();
+
+    // Safe-travel move in progress (only meaningful in Hopping).
+    // The XY path reuses from_x_/from_y_ and delta_x_/delta_y_.
+    DeckModel deck_;
+    long hop_z_;             // Lift Z at the target
+    float hop_f_;            // Part of the XY path already travelled (0 ... 1)
+    float hop_df_;           // XY path travelled per slice at the rapid speed
+
+    void beginHop(const LinearDirective& lin);
+
+    // Returns an event if the deck changed and the path can no longer be cleared
+    Reply updateHop();
+
+    // Take over the current position as the planning origin
+    void syncPlan();
+
+    // Handle a G-code command (cmd.ack set); returns the reply
+    Reply fetchGcode(const Command& cmd);
+
+    // "X:.. Y:.. Z:.. V:.." in mm / ml
+    Reply positionReport();
 };
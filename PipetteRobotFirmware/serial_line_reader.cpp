@@ -0,0 +1,137 @@
+#include <Arduino.h>
+#include "serial_line_reader.h"
+
+SerialLineReader::SerialLineReader() {
+    flush();
+    dropped_ = 0;
+    discarding_ = false;
+}
+
+bool SerialLineReader::poll() {
+    bool halt = false;
+
+    // Leave bytes in the hardware buffer once the ring is full
+    while (count_ < rx_buffer_size && Serial.available()) {
+        char c = Serial.read();
+
+        if (c == realtime_halt) {
+            halt = true;
+            dropped_ += lines_;
+            // A line cut in two by the halt is dropped as a whole
+            if (count_ > 0 && ring_[(head_ + rx_buffer_size - 1) % rx_buffer_size] != '\n') {
+                discarding_ = true;
+            }
+            flush();
+            continue;
+        }
+
+        if (discarding_) {
+            if (c == '\n') {
+                discarding_ = false;
+                dropped_++;
+            }
+            continue;
+        }
+
+        ring_[head_] = c;
+        head_ = (head_ + 1) % rx_buffer_size;
+        count_++;
+        if (c == '\n') lines_++;
+    }
+
+    // A full ring without a newline is an overlong line: drop the rest too
+    if (count_ == rx_buffer_size && lines_ == 0) {
+        flush();
+        discarding_ = true;
+    }
+
+    return halt;
+}
+
+bool SerialLineReader::readLine(char* out, uint8_t size) {
+    if (lines_ == 0) return false;
+
+    uint8_t length;
+    consume(copyLine(tail_, out, size, length));
+
+    if (length > max_line_length) {
+        dropped_++;
+        return false;
+    }
+    return true;
+}
+
+uint8_t SerialLineReader::lines() {
+    return lines_;
+}
+
+int8_t SerialLineReader::findLine(uint8_t from, bool (*match)(const char* line)) {
+    char line[max_line_length + 1];
+    uint8_t at = tail_;
+
+    for (uint8_t i = 0; i < lines_; i++) {
+        uint8_t length;
+        uint8_t next = copyLine(at, line, sizeof(line), length);
+        if (i >= from && length <= max_line_length && match(line)) return i;
+        at = next;
+    }
+    return -1;
+}
+
+void SerialLineReader::dropLines(uint8_t n) {
+    while (n > 0 && lines_ > 0) {
+        uint8_t at = tail_;
+        while (ring_[at] != '\n') at = (at + 1) % rx_buffer_size;
+        consume((at + 1) % rx_buffer_size);
+        dropped_++;
+        n--;
+    }
+}
+
+void SerialLineReader::countDropped() {
+    dropped_++;
+}
+
+uint8_t SerialLineReader::dropped() {
+    return dropped_;
+}
+
+void SerialLineReader::acknowledgeDropped() {
+    if (dropped_ > 0) dropped_--;
+}
+
+uint8_t SerialLineReader::copyLine(uint8_t from, char* out, uint8_t size, uint8_t& length) {
+    uint8_t limit = size - 1 < max_line_length ? size - 1 : max_line_length;
+    uint8_t n = 0;
+    uint8_t at = from;
+    bool fits = true;
+
+    while (true) {
+        char c = ring_[at];
+        at = (at + 1) % rx_buffer_size;
+
+        if (c == '\n') break;
+        if (c == '\r') continue;
+        if (n < limit) out[n++] = c;
+        else fits = false;
+    }
+    out[n] = '\0';
+    length = fits ? n : max_line_length + 1;
+
+    return at;
+}
+
+void SerialLineReader::consume(uint8_t next) {
+    // A line filling the whole ring ends where it started
+    uint8_t bytes = (next + rx_buffer_size - tail_) % rx_buffer_size;
+    count_ -= bytes == 0 ? rx_buffer_size : bytes;
+    tail_ = next;
+    lines_--;
+}
+
+void SerialLineReader::flush() {
+    head_ = 0;
+    tail_ = 0;
+    count_ = 0;
+    lines_ = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+#include "stdint.h"
+
+// Receive ring size in bytes.
+// G-code senders using character-counting flow control must keep the
+// total length of unacknowledged lines (including '\n') within this size.
+static constexpr uint8_t rx_buffer_size = 128;
+
+// Longest accepted line; longer lines are dropped
+static constexpr uint8_t max_line_length = 64;
+
+// Real-time halt character, acted on as soon as it is received
+static constexpr char realtime_halt = '!';
+
+// SerialLineReader drains the Serial RX buffer into its own ring every
+// loop() and hands out complete lines.
+// Reading eagerly means lines can wait here while the robot is busy
+// (the "ok" for a G-code line is sent only when it is consumed), and
+// a real-time halt is seen even while earlier lines are still queued.
+//
+// Lines that never reach readLine() (longer than max_line_length, or
+// received before a real-time halt) are counted as dropped; the caller
+// answers each one, so character-counting senders stay in step.
+class SerialLineReader {
+public:
+    SerialLineReader();
+
+    // Move available bytes into the ring.
+    // Returns true if a real-time halt character arrived; buffered lines
+    // are then dropped, since lines sent before a halt must not run after it.
+    bool poll();
+
+    // Copy the oldest complete line (without '\r'/'\n') into out.
+    // Returns false if no complete line is buffered, or if it was too long
+    // (it is then consumed and counted as dropped).
+    bool readLine(char* out, uint8_t size);
+
+    // Complete lines buffered
+    uint8_t lines();
+
+    // Index of the first buffered line, from line from on, that match
+    // accepts (overlong lines never match), or -1
+    int8_t findLine(uint8_t from, bool (*match)(const char* line));
+
+    // Drop the n oldest lines (they count as dropped)
+    void dropLines(uint8_t n);
+
+    // Count a line readLine() already handed out as dropped (it never ran)
+    void countDropped();
+
+    // Dropped lines not answered yet, and answering one of them
+    uint8_t dropped();
+    void acknowledgeDropped();
+
+private:
+    char ring_[rx_buffer_size];
+    uint8_t head_;   // Next write position
+    uint8_t tail_;   // Next read position
+    uint8_t count_;  // Bytes buffered
+    uint8_t lines_;  // Complete lines buffered
+    uint8_t dropped_; // Dropped lines not answered yet
+    bool discarding_; // Skipping the rest of a dropped line up to its '\n'
+
+    // Copy the line starting at from into out; returns the position after
+    // it. length is set to its length, or more than max_line_length if it
+    // does not fit.
+    uint8_t copyLine(uint8_t from, char* out, uint8_t size, uint8_t& length);
+
+    // Remove the oldest line, which ends just before next
+    void consume(uint8_t next);
+
+    void flush();
+};
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+#include "serial_reply_writer.h"
+
+SerialReplyWriter::SerialReplyWriter() {
+    head_ = 0;
+    tail_ = 0;
+    count_ = 0;
+    has_deferred_ = false;
+}
+
+bool SerialReplyWriter::hasRoom() {
+    return !has_deferred_ && ringHasRoom();
+}
+
+bool SerialReplyWriter::ringHasRoom() {
+    return tx_buffer_size - count_ >= max_reply_length;
+}
+
+void SerialReplyWriter::send(const Reply& reply) {
+    if (reply.empty()) return;
+
+    // Only unsolicited replies (events, real-time halts) can find no room;
+    // they wait in the slot rather than hold up loop()
+    poll();
+    if (!hasRoom()) {
+        if (!has_deferred_ || !isEvent(reply.code) || isEvent(deferred_.code)) {
+            deferred_ = reply;
+            has_deferred_ = true;
+        }
+        return;
+    }
+    push(reply);
+    poll();
+}
+
+void SerialReplyWriter::poll() {
+    if (has_deferred_ && ringHasRoom()) {
+        push(deferred_);
+        has_deferred_ = false;
+    }
+
+    int room = Serial.availableForWrite();
+    while (count_ > 0 && room > 0) {
+        Serial.write(uint8_t(ring_[tail_]));
+        tail_ = (tail_ + 1) % tx_buffer_size;
+        count_--;
+        room--;
+    }
+}
+
+void SerialReplyWriter::push(const Reply& reply) {
+    if (reply.code != ReplyCode::None) {
+        char line[max_reply_line + 1];
+        put(line, formatReply(reply, line, sizeof(line)));
+        put("\r\n", 2);
+    }
+    if (reply.ok) put("ok\r\n", 4);
+}
+
+void SerialReplyWriter::put(const char* str, uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+        ring_[head_] = str[i];
+        head_ = (head_ + 1) % tx_buffer_size;
+        count_++;
+    }
+}
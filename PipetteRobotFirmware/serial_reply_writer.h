@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "stdint.h"
+#include "reply.h"
+
+// Transmit ring size in bytes
+static constexpr uint8_t tx_buffer_size = 128;
+
+// Ring space one reply can take: its line, "\r\n" and "ok\r\n"
+static constexpr uint8_t max_reply_length = max_reply_line + 6;
+
+// SerialReplyWriter formats replies into its own ring and hands bytes to
+// Serial only as far as the hardware TX buffer has room, so a reply never
+// blocks loop() (Serial.print waits for the line to drain at 9600 baud).
+//
+// loop() takes the next command only while hasRoom(), which keeps the
+// answers to received lines from ever overflowing the ring. Unsolicited
+// replies (events, the answer to a real-time halt) can still find it full;
+// they wait in a single slot instead, and a newer one replaces the waiting
+// one. Only events are ever lost that way: an event never replaces a
+// waiting halt answer.
+class SerialReplyWriter {
+public:
+    SerialReplyWriter();
+
+    // Room for a reply of any kind (and no unsolicited reply waiting)
+    bool hasRoom();
+
+    // Queue a reply (empty replies are ignored). Never waits: without
+    // room the reply takes the slot.
+    void send(const Reply& reply);
+
+    // Move the waiting reply into the ring once it fits, and queued bytes
+    // into the hardware TX buffer, without waiting
+    void poll();
+
+private:
+    char ring_[tx_buffer_size];
+    uint8_t head_;   // Next write position
+    uint8_t tail_;   // Next read position
+    uint8_t count_;  // Bytes buffered
+
+    // Unsolicited reply waiting for space
+    Reply deferred_;
+    bool has_deferred_;
+
+    // Ring space for one more reply
+    bool ringHasRoom();
+
+    // Format reply into the ring (the caller checked the space)
+    void push(const Reply& reply);
+    void put(const char* str, uint8_t n);
+};
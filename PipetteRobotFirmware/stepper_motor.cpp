@@ -5,14 +5,25 @@
 // Initialize pins and store pulse timing
 StepperMotor::StepperMotor(int step_pin,
                            int dir_pin,
-                           int pulse_width_us)
-    : step_pin_(step_pin),
-      dir_pin_(dir_pin),
-      pulse_width_us_(pulse_width_us)
+                           int pulse_width_us,
+                           int ms_pin)
+    : dir_pin_(dir_pin),
+      step_pin_(step_pin),
+      ms_pin_(ms_pin),
+      pulse_width_us_(pulse_width_us),
+      default_pulse_width_us_(pulse_width_us),
+      microsteps_(1),
+      position_(0)
 {
     // Configure control pins as outputs
     pinMode(step_pin, OUTPUT);
     pinMode(dir_pin, OUTPUT);
+
+    // Start in full steps (the driver's power-up home is a full-step position)
+    if (ms_pin_ != -1) {
+        pinMode(ms_pin_, OUTPUT);
+        digitalWrite(ms_pin_, LOW);
+    }
 }
 
 // Update pulse width (affects stepping speed)
@@ -20,9 +31,37 @@ void StepperMotor::setPulseWidth(int us) {
     pulse_width_us_ = us;
 }
 
+int StepperMotor::defaultPulseWidth() {
+    return default_pulse_width_us_;
+}
+
+void StepperMotor::setMicrosteps(uint8_t microsteps) {
+    if (ms_pin_ == -1 || microsteps == microsteps_) return;
+
+    if (microsteps == 1) {
+        // Finish on the nearest full step; the driver would otherwise
+        // carry the fraction into every following full step
+        long r = position_ % fine_microsteps;
+        if (r < 0) r += fine_microsteps;
+        moveSteps((r * 2 < fine_microsteps) ? -r : fine_microsteps - r);
+    }
+
+    microsteps_ = microsteps;
+    digitalWrite(ms_pin_, (microsteps_ == 1) ? LOW : HIGH);
+}
+
+uint8_t StepperMotor::microsteps() {
+    return microsteps_;
+}
+
+long StepperMotor::position() {
+    return position_;
+}
+
 // Generate n step pulses
 void StepperMotor::moveSteps(long n) {
     if (n == 0) return;
+    position_ += n * (fine_microsteps / microsteps_);
 
     // Set rotation direction
     if (n > 0) {
@@ -35,7 +74,7 @@ void StepperMotor::moveSteps(long n) {
 
     // Generate STEP pulses
     // One step = HIGH → delay → LOW → delay
-    for (int i = 0; i < n; i++) {
+    for (long i = 0; i < n; i++) {
         digitalWrite(step_pin_, HIGH);
         delayMicroseconds(pulse_width_us_);
         digitalWrite(step_pin_, LOW);
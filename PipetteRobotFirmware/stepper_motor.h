@@ -1,5 +1,19 @@
 #pragma once
 
+#include <stdint.h>
+
+// Longest usable pulse width (µs); delayMicroseconds() is only accurate below ~16 ms
+static constexpr long max_pulse_width_us = 10000;
+
+// Microstepping (A4988-style driver with MS1, MS2 and MS3 tied to one pin:
+// LOW = full steps, HIGH = 1/16 steps)
+// fine_microsteps    : microsteps per full step in fine mode
+// max_fine_step_rate : highest step rate (steps/s) used in fine mode; faster
+//                      moves switch to full steps, which the blocking step
+//                      loop can still generate at speed
+static constexpr uint8_t fine_microsteps = 16;
+static constexpr long max_fine_step_rate = 8000;
+
 // Low-level driver for a step/dir type stepper motor driver.
 // This class directly generates STEP pulses with a configurable pulse width (µs).
 class StepperMotor {
@@ -7,14 +21,30 @@ public:
     // step_pin       : GPIO connected to STEP input of the driver
     // dir_pin        : GPIO connected to DIR input of the driver
     // pulse_width_us : delay between HIGH and LOW (µs), controls stepping speed
-    StepperMotor(int step_pin, int dir_pin, int pulse_width_us);
+    // ms_pin         : GPIO driving the microstep-select inputs (-1 = not
+    //                  wired, the driver stays in full steps)
+    StepperMotor(int step_pin, int dir_pin, int pulse_width_us, int ms_pin = -1);
 
     // Change pulse width (µs)
     // Smaller value → faster stepping
     // Larger value  → slower stepping
     void setPulseWidth(int us);
 
-    // Move motor by n steps
+    // Pulse width given at construction (µs, in full steps)
+    int defaultPulseWidth();
+
+    // Switch between full steps (1) and fine_microsteps.
+    // Before a switch to full steps the motor first moves to the nearest
+    // full-step position, so position() stays exact across switches.
+    void setMicrosteps(uint8_t microsteps);
+
+    // Current microsteps per full step
+    uint8_t microsteps();
+
+    // Position since power-up in 1/fine_microsteps of a full step
+    long position();
+
+    // Move motor by n steps (of the current size)
     // n > 0 : CW rotation (DIR = HIGH)
     // n < 0 : CCW rotation (DIR = LOW)
     void moveSteps(long n);
@@ -22,5 +52,9 @@ public:
 private:
     int dir_pin_;         // Direction control pin
     int step_pin_;        // Step pulse pin
+    int ms_pin_;          // Microstep-select pin (-1 = none)
     int pulse_width_us_;  // Interval between HIGH and LOW pulses (µs)
+    int default_pulse_width_us_; // Pulse width given at construction (µs)
+    uint8_t microsteps_;  // Current microsteps per full step
+    long position_;       // 1/fine_microsteps steps since power-up
 };
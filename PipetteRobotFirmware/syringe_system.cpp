@@ -7,35 +7,57 @@ SyringeSystem::SyringeSystem(LeadScrew& lead_screw, AxisDirection z_dir)
     : lead_screw_(lead_screw),
       z_dir_(z_dir)
 {
-    current_pos_ = 0;
+    liquid_um_ = 0;
     dir_ = SyringeDirection::None;
-    remaining_ticks_ = 0;
+
+    air_gap_um_ = 0;
+    blowout_um_ = 0;
+
+    stroke_ticks_ = 0;
+    stroke_blowout_ = false;
+    stroke_um_ = 0;
+    stroke_done_um_ = 0;
+    stroke_velocity_ = 0;
+    adjust_done_um_ = -1;
+
+    speed_ = syringe_max_um_per_s;
+    accel_ = 0;
+
+    mix_cycles_ = 0;
+    mix_stroke_um_ = 0;
+    mix_pos_um_ = 0;
+    mix_pulling_ = true;
+    mix_pull_speed_ = syringe_max_um_per_s;
+    mix_push_speed_ = syringe_max_um_per_s;
 }
 
-// Validate and queue tick request
+// Validate and start a tick request
 bool SyringeSystem::requestTicks(SyringeDirection dir, int ticks) {
-    if (dir == SyringeDirection::None) {
+    if (dir == SyringeDirection::None || ticks < 0) {
         return false;
     }
 
     bool accepted = false;
+    long um = ticks * um_per_tick_;
 
     if (dir == SyringeDirection::Pull) {
         // Ensure we do not exceed capacity
-        accepted = current_pos_ + ticks <= capacity_;
-        if (accepted) {
-            dir_ = SyringeDirection::Pull;
-        }
+        accepted = hasRoom(ticks, 0);
     } else {
         // Ensure we do not push beyond zero
-        accepted = current_pos_ >= ticks;
-        if (accepted) {
-            dir_ = SyringeDirection::Push;
-        }
+        accepted = getCurrentPos() >= ticks;
+
+        // Emptying the syringe pushes exactly what it holds. Air in front of
+        // the liquid goes first, blowout air last.
+        bool all = (ticks == getCurrentPos());
+        if (all) um = liquid_um_;
+        um += air_gap_um_;
+        if (all) um += blowout_um_;
     }
 
     if (accepted) {
-        remaining_ticks_ = ticks;
+        stroke_ticks_ = ticks;
+        startStroke(dir, um);
     }
 
     return accepted;
@@ -43,47 +65,93 @@ bool SyringeSystem::requestTicks(SyringeDirection dir, int ticks) {
 
 // Push all currently aspirated volume
 void SyringeSystem::requestPushAll() {
-    requestTicks(SyringeDirection::Push, current_pos_);
+    requestTicks(SyringeDirection::Push, getCurrentPos());
 }
 
-// Execute exactly one tick of plunger motion
-void SyringeSystem::advanceOneTick() {
-    if (dir_ == SyringeDirection::None) return;
+bool SyringeSystem::requestAir(long um, bool blowout) {
+    if (um <= 0 || !hasRoom(0, um)) return false;
+    stroke_ticks_ = 0;
+    stroke_blowout_ = blowout;
+    startStroke(SyringeDirection::Pull, um);
+    return true;
+}
 
-    // If finished, stop motion
-    if (remaining_ticks_ == 0) {
-        if (dir_ == SyringeDirection::Pull) {
-            // Apply slight correction after pull
-            adjustPosition();
-        }
-        dir_ = SyringeDirection::None;
+bool SyringeSystem::hasRoom(int ticks, long air_um) {
+    long used = liquid_um_ + air_gap_um_ + blowout_um_;
+    return used + ticks * um_per_tick_ + air_um <= capacity_ * um_per_tick_;
+}
+
+void SyringeSystem::setProfile(long um_per_s, long accel_um_per_s2) {
+    speed_ = constrain(um_per_s, 1L, syringe_max_um_per_s);
+    accel_ = max(accel_um_per_s2, 0L);
+}
+
+void SyringeSystem::startStroke(SyringeDirection dir, long um) {
+    dir_ = dir;
+    stroke_um_ = um;
+    stroke_done_um_ = 0;
+    stroke_velocity_ = 0;
+    adjust_done_um_ = -1;
+}
+
+// Trapezoidal profile: speed up by accel · slice, and never faster than
+// what still allows stopping at the end of the stroke (v² = 2·a·s)
+void SyringeSystem::advance(long slice_ms) {
+    if (dir_ == SyringeDirection::None) return;
+    if (adjust_done_um_ >= 0) {
+        adjustPosition(slice_ms);
         return;
     }
-    else if (remaining_ticks_ < 0) {
-        // Safety fallback
-        dir_ = SyringeDirection::None;
-        remaining_ticks_ = 0;
+
+    long left = stroke_um_ - stroke_done_um_;
+    if (left <= 0) {
+        finishStroke();
         return;
     }
 
-    int sign = 0;
-
-    // Update logical position
-    if (dir_ == SyringeDirection::Pull) {
-        sign = 1;
-        current_pos_++;
-    } else {
-        sign = -1;
-        current_pos_--;
+    long v = speed_;
+    if (accel_ > 0) {
+        v = min(v, stroke_velocity_ + accel_ * slice_ms / 1000);
+        v = min(v, long(sqrt(2.0f * float(accel_) * float(left))));
+        v = max(v, 1L);
     }
+    stroke_velocity_ = v;
+
+    // Travel one slice at that speed; the stepping rate matches it, so the
+    // slice takes about slice_ms
+    long um = min(max(v * slice_ms / 1000, 1L), left);
+    long sign = (dir_ == SyringeDirection::Pull) ? 1 : -1;
+    lead_screw_.setSpeed(v);
+    lead_screw_.move(sign * static_cast<long>(z_dir_) * um);
+    stroke_done_um_ += um;
+}
 
-    // Convert one tick into linear displacement (µm)
-    long um = sign * static_cast<long>(z_dir_) * um_per_tick_;
+void SyringeSystem::finishStroke() {
+    // The ramp has slowed down to a crawl by now
+    lead_screw_.resetSpeed();
 
-    // Move plunger
-    lead_screw_.move(um);
+    if (dir_ == SyringeDirection::Pull) {
+        if (stroke_ticks_ > 0) {
+            liquid_um_ += stroke_ticks_ * um_per_tick_;
+            // Apply slight correction after pull (the request runs on)
+            adjust_done_um_ = 0;
+            return;
+        }
+        else if (stroke_blowout_) {
+            blowout_um_ += stroke_um_;
+        }
+        else {
+            air_gap_um_ += stroke_um_;
+        }
+    }
+    else {
+        // The stroke took the air gap first (and the blowout air last)
+        liquid_um_ = max(liquid_um_ - (stroke_um_ - air_gap_um_), 0L);
+        air_gap_um_ = 0;
+        if (liquid_um_ == 0) blowout_um_ = 0;
+    }
 
-    remaining_ticks_--;
+    dir_ = SyringeDirection::None;
 }
 
 // Return current motion state
@@ -93,12 +161,142 @@ SyringeDirection SyringeSystem::getSyringeDirection() {
 
 // Return current plunger position in ticks
 int SyringeSystem::getCurrentPos() {
-    return current_pos_;
+    return (liquid_um_ + um_per_tick_ / 2) / um_per_tick_;
+}
+
+long SyringeSystem::blowoutHeld() {
+    return blowout_um_;
+}
+
+long SyringeSystem::airGapHeld() {
+    return air_gap_um_;
+}
+
+long SyringeSystem::capacityUm() {
+    return capacity_ * umPerTick();
+}
+
+// Apply small forward/backward motion to reduce backlash, at the default
+// speed so a slice takes about slice_ms
+void SyringeSystem::adjustPosition(long slice_ms) {
+    long um = max(lead_screw_.defaultSpeed() * slice_ms / 1000, 1L);
+    long sign = 1;
+    if (adjust_done_um_ < um_per_tick_) {
+        um = min(um, um_per_tick_ - adjust_done_um_);
+    }
+    else {
+        um = min(um, 2 * um_per_tick_ - adjust_done_um_);
+        sign = -1;
+    }
+    lead_screw_.move(sign * static_cast<long>(z_dir_) * um);
+    adjust_done_um_ += um;
+
+    if (adjust_done_um_ >= 2 * um_per_tick_) {
+        adjust_done_um_ = -1;
+        dir_ = SyringeDirection::None;
+    }
+}
+
+// Validate and start a mixing cycle
+bool SyringeSystem::requestMix(int ticks, int cycles, long pull_um_per_s, long push_um_per_s) {
+    if (ticks <= 0 || cycles <= 0) return false;
+
+    // The aspirated stroke has to fit on top of the current volume
+    if (!hasRoom(ticks, 0)) return false;
+
+    mix_cycles_ = cycles;
+    mix_stroke_um_ = ticks * um_per_tick_;
+    mix_pos_um_ = 0;
+    mix_pulling_ = true;
+    mix_pull_speed_ = constrain(pull_um_per_s, 1L, syringe_max_um_per_s);
+    mix_push_speed_ = constrain(push_um_per_s, 1L, syringe_max_um_per_s);
+
+    lead_screw_.setSpeed(mix_pull_speed_);
+    return true;
+}
+
+// Triangle profile: constant speed, direction flips at both ends
+long SyringeSystem::advanceMix(long slice_ms) {
+    if (mix_cycles_ == 0) return mix_pos_um_;
+
+    // Travel available in this slice at the configured speed
+    long speed = mix_pulling_ ? mix_pull_speed_ : mix_push_speed_;
+    long um = max(speed * slice_ms / 1000, 1L);
+    um = min(um, mix_pulling_ ? mix_stroke_um_ - mix_pos_um_ : mix_pos_um_);
+
+    long sign = mix_pulling_ ? 1 : -1;
+    lead_screw_.move(sign * static_cast<long>(z_dir_) * um);
+    mix_pos_um_ += sign * um;
+
+    if (mix_pulling_ && mix_pos_um_ >= mix_stroke_um_) {
+        mix_pulling_ = false;
+        lead_screw_.setSpeed(mix_push_speed_);
+    }
+    else if (!mix_pulling_ && mix_pos_um_ <= 0) {
+        mix_pulling_ = true;
+        mix_cycles_--;
+        if (mix_cycles_ == 0) {
+            lead_screw_.resetSpeed();
+        }
+        else {
+            lead_screw_.setSpeed(mix_pull_speed_);
+        }
+    }
+
+    return mix_pos_um_;
+}
+
+bool SyringeSystem::isMixing() {
+    return mix_cycles_ > 0;
+}
+
+long SyringeSystem::mixStroke() {
+    return mix_stroke_um_;
+}
+
+void SyringeSystem::cancel() {
+    if (mix_cycles_ > 0) {
+        liquid_um_ += mix_pos_um_;
+        mix_cycles_ = 0;
+        mix_pos_um_ = 0;
+        lead_screw_.resetSpeed();
+    }
+
+    if (dir_ == SyringeDirection::Pull && adjust_done_um_ >= 0) {
+        // Stopped during the backlash correction: the plunger is still out
+        // by what it went forward and has not come back yet
+        liquid_um_ += min(adjust_done_um_, 2 * um_per_tick_ - adjust_done_um_);
+        adjust_done_um_ = -1;
+    }
+    else if (dir_ == SyringeDirection::Pull) {
+        long done = stroke_done_um_;
+        if (stroke_ticks_ > 0) liquid_um_ += done;
+        else if (stroke_blowout_) blowout_um_ += done;
+        else air_gap_um_ += done;
+    }
+    else if (dir_ == SyringeDirection::Push) {
+        // Book the travel in the order it left: air gap, liquid, blowout air
+        long done = stroke_done_um_;
+        long air = min(done, air_gap_um_);
+        air_gap_um_ -= air;
+        done -= air;
+
+        long liquid = min(done, liquid_um_);
+        liquid_um_ -= liquid;
+        done -= liquid;
+        blowout_um_ -= min(done, blowout_um_);
+    }
+
+    if (dir_ != SyringeDirection::None) {
+        dir_ = SyringeDirection::None;
+        lead_screw_.resetSpeed();
+    }
+}
+
+long SyringeSystem::umPerTick() {
+    return um_per_tick_;
 }
 
-// Apply small forward/backward motion to reduce backlash
-void SyringeSystem::adjustPosition() {
-    long um = static_cast<long>(z_dir_) * um_per_tick_;
-    lead_screw_.move(um);
-    lead_screw_.move(-um);
+long SyringeSystem::ulToUm(long ul) {
+    return lround(float(ul) / (minimum_ml * 1000.0f) * um_per_tick_);
 }
@@ -14,6 +14,9 @@ static constexpr float minimum_ml = 0.2f;
 static constexpr float syringe_capacity_ml = 5.0f;
 static constexpr float calibration_scale = 1.05f; //1.0 default start point
 
+// Fastest plunger travel (µm/s), reached with a liquid class's acceleration ramp
+static constexpr long syringe_max_um_per_s = 20000;
+
 // Direction of syringe motion
 enum class SyringeDirection {
     None,  // Idle
@@ -31,33 +34,110 @@ public:
 
     // Request movement in discrete ticks.
     // ticks correspond to minimum_ml per tick.
+    // A push also expels the air gap held in front of the liquid, and the
+    // blowout air when it empties the syringe.
     // Returns true if the request is within capacity limits.
     bool requestTicks(SyringeDirection dir, int ticks);
 
     // Convenience: push entire current volume.
     void requestPushAll();
 
-    // Execute exactly one tick of motion.
+    // Draw air (µm of plunger travel) as blowout reserve or as air gap.
+    // Returns false if it does not fit.
+    bool requestAir(long um, bool blowout);
+
+    // True if ticks of liquid plus air_um of air still fit
+    bool hasRoom(int ticks, long air_um);
+
+    // Plunger speed (µm/s) and ramp (µm/s², 0 = none) of following requests
+    void setProfile(long um_per_s, long accel_um_per_s2);
+
+    // Advance the running request by one time slice (ms): accelerate up to
+    // the profile speed and decelerate into the end of the stroke.
     // Called repeatedly from Robot::update().
-    void advanceOneTick();
+    void advance(long slice_ms);
 
-    // Current active syringe direction
+    // Current active syringe direction (None once a request has finished)
     SyringeDirection getSyringeDirection();
 
-    // Current position in ticks (0 ... capacity_)
+    // Current position in ticks (0 ... capacity_), rounded to the nearest
+    // tick after a stroke or mix stopped half way
     int getCurrentPos();
 
-    // Small corrective motion to compensate backlash/mechanical play
-    void adjustPosition();
+    // Blowout air held behind the liquid (µm of plunger travel)
+    long blowoutHeld();
+
+    // Air gap held in front of the liquid (µm of plunger travel)
+    long airGapHeld();
+
+    // Full plunger travel (µm)
+    static long capacityUm();
+
+    // Request a mixing cycle: aspirate ticks, dispense them again, repeat.
+    // pull/push_um_per_s are the plunger speeds of the two strokes
+    // (clamped to syringe_max_um_per_s).
+    // Returns false if the stroke would exceed capacity.
+    bool requestMix(int ticks, int cycles, long pull_um_per_s, long push_um_per_s);
+
+    // Advance the mix by one time slice (ms) at constant plunger speed,
+    // reversing at each end of the stroke. Returns the stroke position
+    // afterwards (µm above the starting point).
+    long advanceMix(long slice_ms);
+
+    // True while a mix is running
+    bool isMixing();
+
+    // Mix stroke length (µm)
+    long mixStroke();
+
+    // Abandon any running request (halt). Liquid moved by a stroke or mix
+    // stopped half way is booked as it was moved, so the books match the plunger.
+    void cancel();
+
+    // Plunger travel per tick (µm)
+    static long umPerTick();
+
+    // Volume (µl) → plunger travel (µm)
+    static long ulToUm(long ul);
 
 private:
     LeadScrew& lead_screw_;
 
-    int current_pos_;       // Current plunger position (ticks)
-    int remaining_ticks_;   // Remaining ticks to execute
+    long liquid_um_;        // Liquid held (µm of plunger travel)
     SyringeDirection dir_;  // Current motion direction
     AxisDirection z_dir_;   // Direction correction
 
+    // Air held in the syringe (µm of plunger travel)
+    long air_gap_um_;       // On top of the liquid, leaves first
+    long blowout_um_;       // Below the liquid, leaves last
+
+    // Stroke in progress (only meaningful while dir_ != None)
+    int stroke_ticks_;      // Liquid moved by the stroke (0 = air only)
+    bool stroke_blowout_;   // Air stroke draws blowout air (else air gap)
+    long stroke_um_;        // Total travel (µm)
+    long stroke_done_um_;   // Travel already made
+    long stroke_velocity_;  // Current speed (µm/s)
+    long adjust_done_um_;   // Backlash correction made (-1 = not started)
+
+    // Profile of following strokes
+    long speed_;            // Cruise speed (µm/s)
+    long accel_;            // µm/s² (0 = no ramp)
+
+    void startStroke(SyringeDirection dir, long um);
+    void finishStroke();
+
+    // Small corrective motion to compensate backlash/mechanical play after
+    // a pull: one tick forward and back, one slice (ms) per call
+    void adjustPosition(long slice_ms);
+
+    // Mix state
+    int mix_cycles_;        // Cycles left (a cycle = pull then push)
+    long mix_stroke_um_;    // Stroke length (µm)
+    long mix_pos_um_;       // Current position within the stroke (µm)
+    bool mix_pulling_;      // Current stroke direction
+    long mix_pull_speed_;   // Plunger speed while aspirating (µm/s)
+    long mix_push_speed_;   // Plunger speed while dispensing (µm/s)
+
     // Maximum capacity in ticks (e.g., 25 ticks × 0.2 ml = 5 ml)
     static constexpr int capacity_ = lround(syringe_capacity_ml / minimum_ml);
 
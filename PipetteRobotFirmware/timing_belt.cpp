@@ -4,18 +4,40 @@
 #include "stdint.h"
 
 // Store motor reference (no ownership)
-TimingBelt::TimingBelt(StepperMotor& motor) : motor_(motor) {}
+TimingBelt::TimingBelt(StepperMotor& motor) : motor_(motor), um_(0) {}
 
-// Convert requested linear distance (µm) to steps
-// and forward to the stepper motor
+// Convert requested linear displacement (µm) into motor steps
+// and forward to the stepper motor.
+// The target is rounded down to a whole step of the current size; the
+// fraction is picked up by the next move.
 void TimingBelt::move(long um) {
-    long n = umToStep(um);
-    motor_.moveSteps(n);
+    um_ += um;
+    long step = fine_microsteps / motor_.microsteps();
+    long target = umToPosition(um_) / step * step;
+    motor_.moveSteps((target - motor_.position()) / step);
 }
 
-// Simple integer conversion:
-// steps = distance / (µm per step)
-// Note: fractional steps are truncated.
-int TimingBelt::umToStep(long um) {
-    return um / um_per_step_;
+// One step = two pulse widths, so half period = (µm/step) / (2 · µm/s)
+void TimingBelt::setSpeed(long um_per_s) {
+    if (um_per_s <= 0) return;
+    bool fine = um_per_s * fine_microsteps <= max_fine_step_rate * um_per_step_;
+    bool was_fine = motor_.microsteps() == fine_microsteps;
+    motor_.setMicrosteps(fine ? fine_microsteps : 1);
+
+    long us = um_per_step_ * 500000L / (um_per_s * motor_.microsteps());
+    motor_.setPulseWidth(constrain(us, 1L, max_pulse_width_us));
+
+    // Back from full steps: move the fraction of a step they left over
+    if (fine && !was_fine) move(0);
+}
+
+// The default pulse width is given in full steps
+void TimingBelt::resetSpeed() {
+    setSpeed(um_per_step_ * 500000L / motor_.defaultPulseWidth());
+}
+
+// position = distance / (µm per step) · microsteps
+// Note: fractional microsteps are truncated.
+long TimingBelt::umToPosition(long um) {
+    return um * fine_microsteps / um_per_step_;
 }
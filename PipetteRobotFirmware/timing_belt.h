@@ -15,14 +15,30 @@ public:
     // Positive/negative sign determines direction
     void move(long um);
 
+    // Set linear speed (µm/s) used by following moves.
+    // Picks fine microsteps unless the step rate would exceed
+    // max_fine_step_rate, then full steps. Going back to fine microsteps
+    // first moves the fraction of a full step the last moves left over.
+    void setSpeed(long um_per_s);
+
+    // Back to the motor's default speed (fine microsteps, so this also
+    // finishes a move made in full steps)
+    void resetSpeed();
+
 private:
     StepperMotor& motor_;
 
     // Mechanical resolution:
-    // Linear distance per one motor step (µm/step)
+    // Linear distance per one full motor step (µm/step)
     // This value depends on pulley diameter and step angle.
     static constexpr long um_per_step_ = 200;
 
-    // Convert micrometers to motor steps
-    int umToStep(long um);
+    // Total distance requested since power-up (µm). The motor is kept at
+    // this distance rounded to the current step size, so small moves (e.g.
+    // slow jogging) do not truncate to zero and no fraction is lost when
+    // the step size changes.
+    long um_;
+
+    // Convert micrometers to motor position (1/fine_microsteps steps)
+    long umToPosition(long um);
 };
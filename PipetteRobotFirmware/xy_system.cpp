@@ -10,29 +10,60 @@ XYSystem::XYSystem(TimingBelt& x_belt,
     : x_belt_(x_belt),
       y_belt_(y_belt),
       x_dir_(x_dir),
-      y_dir_(y_dir) {}
+      y_dir_(y_dir),
+      x_um_(0),
+      y_um_(0) {}
 
 // Move in +Y logical direction
 // Apply direction correction before passing to belt
 void XYSystem::moveUp(long um) {
+    y_um_ += um;
     um = static_cast<long>(y_dir_) * um;
     y_belt_.move(um);
 }
 
 // Move in -Y logical direction
 void XYSystem::moveDown(long um) {
+    y_um_ -= um;
     um = -static_cast<long>(y_dir_) * um;
     y_belt_.move(um);
 }
 
 // Move in +X logical direction
 void XYSystem::moveRight(long um) {
+    x_um_ += um;
     um = static_cast<long>(x_dir_) * um;
     x_belt_.move(um);
 }
 
 // Move in -X logical direction
 void XYSystem::moveLeft(long um) {
+    x_um_ -= um;
     um = -static_cast<long>(x_dir_) * um;
     x_belt_.move(um);
 }
+
+long XYSystem::getX() {
+    return x_um_;
+}
+
+long XYSystem::getY() {
+    return y_um_;
+}
+
+// Redefine the current position (no motion)
+void XYSystem::setPosition(long x_um, long y_um) {
+    x_um_ = x_um;
+    y_um_ = y_um;
+}
+
+// Both axes share one speed setting
+void XYSystem::setSpeed(long um_per_s) {
+    x_belt_.setSpeed(um_per_s);
+    y_belt_.setSpeed(um_per_s);
+}
+
+void XYSystem::resetSpeed() {
+    x_belt_.resetSpeed();
+    y_belt_.resetSpeed();
+}
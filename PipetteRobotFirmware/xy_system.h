@@ -21,6 +21,15 @@ public:
     void moveRight(long um);
     void moveLeft(long um);
 
+    // Logical position (µm) relative to the power-on / G92 origin
+    long getX();
+    long getY();
+    void setPosition(long x_um, long y_um);
+
+    // Speed of both belts for following moves (µm/s), or back to default
+    void setSpeed(long um_per_s);
+    void resetSpeed();
+
 private:
     TimingBelt& x_belt_;
     TimingBelt& y_belt_;
@@ -28,4 +37,8 @@ private:
     // Used to align logical coordinate system with hardware orientation
     AxisDirection x_dir_;
     AxisDirection y_dir_;
+
+    // Commanded logical position (µm)
+    long x_um_;
+    long y_um_;
 };
@@ -1,25 +1,32 @@
+import argparse
+import os
+import re
+
 from flask import Flask, render_template, request, jsonify
-import serial
+
+from fleet import Fleet, parse_robot_specs
 
 # Flask app instance
 app = Flask(__name__)
 
-# Serial connection settings for Arduino
+# Serial port used when no robots are configured
 DEFAULT_PORT = "/dev/ttyACM0"
-BAUD_RATE = 9600
 
-# Global serial handle (initialized on startup)
-ser = None
+# Robots driven by this server (initialized on startup)
+fleet = None
 
-def init_serial():
-    """Initialize the serial connection to the device."""
-    global ser
-    try:
-        ser = serial.Serial(DEFAULT_PORT, BAUD_RATE, timeout=1)
-        print(f"Serial initialized on {DEFAULT_PORT} ({BAUD_RATE} baud)", flush=True)
-    except Exception as e:
-        print(f"Failed to open {DEFAULT_PORT}: {e}", flush=True)
-        ser = None
+def init_fleet(specs):
+    """Create one serial worker per robot and start the job scheduler.
+
+    specs : ["name=port", ...]; ROBOT_PORTS (comma separated) is used when empty
+    """
+    global fleet
+    if not specs:
+        specs = [s for s in os.environ.get("ROBOT_PORTS", "").split(",") if s]
+    if not specs:
+        specs = [DEFAULT_PORT]
+    fleet = Fleet(parse_robot_specs(specs))
+    fleet.start()
 
 
 @app.route("/")
@@ -27,6 +34,14 @@ def index():
     """Serve the main GUI page."""
     return render_template("index.html")
 
+def liquid_suffix(payload):
+    """Optional liquid class name appended to syringe commands (" water")."""
+    liquid = payload.get("liquid")
+    if liquid is None:
+        return ""
+    assert isinstance(liquid, str) and re.fullmatch(r"[A-Za-z][A-Za-z0-9_]{0,7}", liquid)
+    return " " + liquid
+
 def json_to_command(data):
     """Convert GUI JSON payload into a single-line command for the device."""
     assert isinstance(data, dict)
@@ -58,6 +73,19 @@ def json_to_command(data):
         elif button_state == "released":
             return "RELEASED"
 
+    # Velocity jog: velocity in mm/s (signed), device expects µm/s.
+    # The GUI repeats the frame while the button is held (deadman keepalive);
+    # repeats are marked " K" so the device never starts motion from one.
+    elif data_type == "jog":
+        payload = data.get("payload")
+        assert isinstance(payload, dict)
+        axis = payload.get("axis")
+        assert axis in ("X", "Y", "Z")
+        velocity = payload.get("velocity")
+        assert isinstance(velocity, (int, float))
+        keepalive = " K" if payload.get("keepalive") else ""
+        return f"JOG {axis} {round(velocity * 1000)}{keepalive}"
+
     # Syringe commands: convert float value into discrete "ticks"
     elif data_type == "syringes":
         payload = data.get("payload")
@@ -66,24 +94,68 @@ def json_to_command(data):
         value = payload.get("value")
         assert isinstance(value, (int, float))
         ticks = round(value * 5)  # 0.2 step -> integer ticks
+        liquid = liquid_suffix(payload)
         if cmd == "PULL":
-            return cmd + " " + str(ticks)
+            return cmd + " " + str(ticks) + liquid
         elif cmd == "PUSH":
-            return cmd + " " + str(ticks)
+            return cmd + " " + str(ticks) + liquid
         elif cmd == "PUSHALL":
-            return "PUSH -1"  # special value meaning "push all"
+            return "PUSH -1" + liquid  # special value meaning "push all"
+
+    # Mixing: volume (ml) per stroke, cycle count, optional flow (ml/s) and
+    # lift travel (mm) that follows the liquid level. Runs on the controller,
+    # which answers "Mix ..." now and sends the "#Mix done" event when finished.
+    elif data_type == "mix":
+        payload = data.get("payload")
+        assert isinstance(payload, dict)
+        value = payload.get("value")
+        cycles = payload.get("cycles")
+        assert isinstance(value, (int, float)) and isinstance(cycles, int)
+        flow = payload.get("flow", 0)
+        z = payload.get("z", 0)
+        assert isinstance(flow, (int, float)) and isinstance(z, (int, float))
+        ticks = round(value * 5)  # 0.2 step -> integer ticks
+        return f"MIX {ticks} {cycles} {round(flow * 1000)} {round(z * 1000)}{liquid_suffix(payload)}"
+
+    # Liquid class: select by name, or define it when flows are given.
+    # Flows in ml/s, acceleration in ml/s², settle in s, air volumes in ml;
+    # the device expects µl and ms.
+    elif data_type == "liquid":
+        payload = data.get("payload")
+        assert isinstance(payload, dict)
+        cmd = "LIQUID" + liquid_suffix(payload)
+        assert cmd != "LIQUID"
+        fields = ("aspirate", "dispense", "accel", "settle", "air_gap", "blowout")
+        values = [payload.get(f) for f in fields]
+        if values[0] is None:
+            return cmd
+        # Fields left out keep the device's current values, so stop at the first gap
+        for value in values:
+            if value is None:
+                break
+            assert isinstance(value, (int, float)) and value >= 0
+            cmd += f" {round(value * 1000)}"
+        return cmd
 
     # Emergency stop
     elif data_type == "halt":
         return "HALT"
 
+def select_robot(data):
+    """Return the robot named in the payload (default: first robot) or None."""
+    name = data.get("robot") if hasattr(data, "get") else None
+    return fleet.get(name or None)
+
+def is_keepalive(data):
+    """True for repeated jog frames sent while a jog button is held."""
+    payload = data.get("payload")
+    return data.get("type") == "jog" and isinstance(payload, dict) and bool(payload.get("keepalive"))
+
 @app.route("/send", methods=["POST"])
 def send_command():
-    """Receive a GUI command, forward it to the device via serial, and return the reply."""
-    global ser
-
+    """Receive a GUI command, forward it to the selected robot, and return the reply."""
     # Parse request body (prefer JSON, fallback to form)
-    data = request.get_json()
+    data = request.get_json(silent=True)
     if data is None:
         data = request.form
 
@@ -91,42 +163,104 @@ def send_command():
     cmd = json_to_command(data)
     if cmd is None:
         cmd = ""
-    cmd.strip()  # NOTE: this does not modify cmd in-place (strings are immutable)
+    cmd = cmd.strip()
 
     # Reject empty commands
     if cmd == "":
         return jsonify({"status": "error", "message": "No command provided."}), 400
 
+    robot = select_robot(data)
+    if robot is None:
+        return jsonify({"status": "error", "message": "Unknown robot."}), 404
+
     # Ensure serial is available
-    if ser is None or not ser.is_open:
+    if not robot.connected:
         return jsonify({
             "status":"error",
+            "robot": robot.name,
             "message": "Serial port is not open."
         }), 500
 
     try:
-        # Clear stale input before sending a new command
-        ser.reset_input_buffer()
-
-        # Send command line to Arduino
-        ser.write((cmd + "\n").encode("utf-8"))
-        ser.flush()
-
-        # Read one-line reply from Arduino
-        reply = ser.readline().decode("utf-8", errors="ignore").strip()
+        # Halt jumps ahead of queued commands and cancels the running job
+        if cmd == "HALT":
+            reply = robot.halt()
+        elif is_keepalive(data):
+            # Keepalive jog frames are fire-and-forget: the firmware stays quiet
+            robot.keepalive(cmd)
+            reply = ""
+        else:
+            reply = robot.send(cmd)
 
         # Return round-trip info to the GUI
         return jsonify({
                 "status": "ok",
+                "robot": robot.name,
                 "sent": cmd,
                 "received": reply
             })
 
     except Exception as e:
         # Return error as JSON for the GUI to display/log
-        return jsonify({"status": "error", "message": str(e)}), 500
+        return jsonify({"status": "error", "robot": robot.name, "message": str(e)}), 500
+
+@app.route("/robots", methods=["GET"])
+def list_robots():
+    """State of every robot (connection, job, last exchange, log)."""
+    return jsonify({"status": "ok", "robots": fleet.snapshot()})
+
+@app.route("/jobs", methods=["GET"])
+def list_jobs():
+    """All submitted protocol jobs and their progress."""
+    return jsonify({"status": "ok", "jobs": fleet.job_snapshot()})
+
+@app.route("/jobs", methods=["POST"])
+def submit_job():
+    """Queue a protocol job; the scheduler runs it on the next idle robot.
+
+    Body: {"robot": optional name, "steps": [GUI payload | {"type": "wait", "seconds": s}, ...]}
+    """
+    data = request.get_json(silent=True)
+    if not isinstance(data, dict) or not isinstance(data.get("steps"), list):
+        return jsonify({"status": "error", "message": "Job needs a list of steps."}), 400
+
+    robot = data.get("robot")
+    if robot is not None and fleet.get(robot) is None:
+        return jsonify({"status": "error", "message": "Unknown robot."}), 404
+
+    # Translate every step up front so a bad protocol is rejected before it starts
+    steps = []
+    try:
+        for step in data["steps"]:
+            if step.get("type") == "wait":
+                steps.append({"wait": float(step.get("seconds", 0))})
+                continue
+            cmd = json_to_command(step)
+            if not cmd:
+                raise ValueError(f"Unsupported step: {step}")
+            steps.append({"command": cmd})
+    except (AssertionError, AttributeError, TypeError, ValueError) as e:
+        return jsonify({"status": "error", "message": f"Invalid step: {e}"}), 400
+
+    job = fleet.submit_job(steps, robot)
+    return jsonify({"status": "ok", "job": job.snapshot()})
+
+@app.route("/jobs/<int:job_id>/cancel", methods=["POST"])
+def cancel_job(job_id):
+    """Cancel a queued or running job (a running step is not interrupted)."""
+    job = fleet.cancel_job(job_id)
+    if job is None:
+        return jsonify({"status": "error", "message": "Unknown job."}), 404
+    return jsonify({"status": "ok", "job": job.snapshot()})
 
 if __name__ == "__main__":
-    # Initialize serial connection once, then start the web server
-    init_serial()
-    app.run(debug=True, use_reloader=False)
+    # Robots are given as "name=port" (or just a port), e.g. bench1=/dev/ttyACM0 bench2=/dev/pts/4
+    parser = argparse.ArgumentParser(description="Pipette robot fleet server")
+    parser.add_argument("robots", nargs="*", help="robot serial ports as name=port")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=5000)
+    args = parser.parse_args()
+
+    # Open every robot once, then start the web server
+    init_fleet(args.robots)
+    app.run(host=args.host, port=args.port, debug=True, use_reloader=False, threaded=True)
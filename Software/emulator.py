@@ -0,0 +1,937 @@
+"""Pseudo-terminal emulator of the pipette robot firmware.
+
+Each emulated robot opens a pty and speaks the firmware's serial protocol
+(plain-text commands, JOG frames and the G-code subset) with the firmware's
+timing: loop() only reads serial between robot.update() calls, and every
+update() blocks for as long as the real step pulses would take.
+
+    python3 emulator.py -n 2
+    # robot0=/dev/pts/3 robot1=/dev/pts/4   <- pass these to app.py / run.sh
+"""
+import argparse
+import math
+import os
+import pty
+import re
+import select
+import threading
+import time
+import tty
+
+# ---- Firmware constants (PipetteRobotFirmware/*.h, .ino) ----
+BAUD_RATE = 9600
+CHAR_TIME_S = 10 / BAUD_RATE            # 8N1: 10 bits per character
+
+PULSE_WIDTH_US = 1000                   # StepperMotor pulse width (HIGH and LOW)
+BELT_UM_PER_STEP = 200                  # TimingBelt
+SCREW_UM_PER_STEP = 10                  # LeadScrew
+MAX_PULSE_WIDTH_US = 10000
+FINE_MICROSTEPS = 16                    # stepper_motor.h
+MICROSTEP_CONTROL = False               # PipetteRobotFirmware.ino (opt-in rewiring)
+MAX_FINE_STEP_RATE = 8000
+
+XY_UM_PER_MOVE = 10000                  # Robot(…, 10000, 1000)
+LIFT_UM_PER_MOVE = 1000
+
+MINIMUM_ML = 0.2                        # syringe_system.h
+AXIS_RADIUS_CM = 1.25 / 2.0
+SYRINGE_CAPACITY_ML = 5.0
+SYRINGE_MAX_UM_PER_S = 20000
+CALIBRATION_SCALE = 1.05
+CAPACITY_TICKS = round(SYRINGE_CAPACITY_ML / MINIMUM_ML)
+UM_PER_TICK = round(MINIMUM_ML / (math.pi * AXIS_RADIUS_CM ** 2) * 10000 * CALIBRATION_SCALE)
+
+MOTION_SLICE_MS = 20                    # robot.h
+XY_MAX_UM_PER_S = 100000
+LIFT_MAX_UM_PER_S = 5000
+XY_RAPID_UM_PER_S = 150000
+LIFT_RAPID_UM_PER_S = 10000
+JOG_KEEPALIVE_MS = 250
+XY_JOG_ACCEL = 400000
+LIFT_JOG_ACCEL = 20000
+MOTION_QUEUE_SIZE = 8
+AIR_RETRACT_UM = 5000
+
+# liquid_class.cpp: name -> (aspirate µl/s, dispense µl/s, accel µl/s², settle ms, air gap µl, blowout µl)
+LIQUID_CLASS_COUNT = 6
+LIQUID_CLASS_NAME_LENGTH = 8
+DEFAULT_LIQUID_CLASSES = {
+    "default": (584, 584, 0, 0, 0, 0),
+    "water": (2000, 2000, 8000, 100, 0, 0),
+    "viscous": (100, 50, 200, 1500, 0, 100),
+    "volatile": (1000, 1000, 4000, 0, 50, 0),
+}
+
+DECK_LABWARE_COUNT = 8                  # deck.h
+HOP_CLEARANCE_UM = 2000
+HOP_MARGIN_UM = 3000
+
+RX_BUFFER_SIZE = 128                    # serial_line_reader.h
+MAX_LINE_LENGTH = 64
+HW_RX_BUFFER_SIZE = 64                  # Arduino core; fills while update() blocks
+TX_BUFFER_SIZE = 128                    # serial_reply_writer.h
+HW_TX_BUFFER_SIZE = 64                  # Arduino core
+MAX_REPLY_LENGTH = 48 + 6
+REALTIME_HALT = b"!"
+LINE_DROPPED = "error: line dropped"
+PLAIN_WORDS = ("X+", "X-", "Y+", "Y-", "Z+", "Z-", "RELEASED", "PULL", "PUSH", "MIX",
+               "LIQUID", "DECK", "TIP", "LABWARE", "JOG")
+
+
+def microsteps_for(um_per_s, um_per_step):
+    """TimingBelt/LeadScrew::setSpeed(): fine steps up to MAX_FINE_STEP_RATE."""
+    if not MICROSTEP_CONTROL:
+        return 1
+    return FINE_MICROSTEPS if um_per_s * FINE_MICROSTEPS <= MAX_FINE_STEP_RATE * um_per_step else 1
+
+
+def move_time_s(um, um_per_step, um_per_s=None):
+    """Blocking time of LeadScrew/TimingBelt.move(um) at a speed (None = default
+    pulse width): two pulse widths per step of the selected size."""
+    if um_per_s is None:
+        um_per_s = um_per_step * 500000 // PULSE_WIDTH_US
+    microsteps = microsteps_for(um_per_s, um_per_step)
+    pulse = max(1, min(MAX_PULSE_WIDTH_US, um_per_step * 500000 // (max(1, um_per_s) * microsteps)))
+    return int(abs(um) * microsteps // um_per_step) * 2 * pulse / 1e6
+
+
+def atol(text):
+    """C atol(): leading sign and digits, anything else (or nothing) is 0."""
+    match = re.match(r"\s*([-+]?\d+)", text)
+    return int(match.group(1)) if match else 0
+
+
+def ul_to_um(ul):
+    """SyringeSystem::ulToUm(): volume → plunger travel."""
+    return round(ul / (MINIMUM_ML * 1000) * UM_PER_TICK)
+
+
+class DeckModel:
+    """deck.cpp: lift Z needed to clear the labware under an XY path."""
+
+    def __init__(self):
+        self.deck_z = None
+        self.tip_length = 0
+        self.labware = [None] * DECK_LABWARE_COUNT   # (x0, y0, x1, y1, height)
+
+    def required(self, lw):
+        return self.deck_z + self.tip_length + lw[4] + HOP_CLEARANCE_UM
+
+    @staticmethod
+    def overlap(lw, start, end):
+        """Part (t_in, t_out) of the path above the grown footprint, or None."""
+        if lw is None or lw[4] <= 0:
+            return None
+        t_in, t_out = 0.0, 1.0
+        for p0, p1, lo, hi in ((start[0], end[0], min(lw[0], lw[2]), max(lw[0], lw[2])),
+                               (start[1], end[1], min(lw[1], lw[3]), max(lw[1], lw[3]))):
+            lo, hi, d = lo - HOP_MARGIN_UM, hi + HOP_MARGIN_UM, p1 - p0
+            if d == 0:
+                if not lo <= p0 <= hi:
+                    return None
+                continue
+            a, b = sorted(((lo - p0) / d, (hi - p0) / d))
+            t_in, t_out = max(t_in, a), min(t_out, b)
+            if t_in > t_out:
+                return None
+        return t_in, t_out
+
+    def clearance(self, start, end, fa, fb):
+        if self.deck_z is None:
+            return 0
+        z = self.deck_z + self.tip_length + HOP_CLEARANCE_UM
+        for lw in self.labware:
+            t = self.overlap(lw, start, end)
+            if t is not None and t[0] <= fb and t[1] >= fa:
+                z = max(z, self.required(lw))
+        return z
+
+    def reach(self, start, end, fa, fb, z):
+        f = fb
+        for lw in self.labware:
+            t = self.overlap(lw, start, end)
+            if t is None or self.required(lw) <= z or t[1] < fa:
+                continue
+            f = min(f, max(t[0], fa))
+        return f
+
+
+def fmt(value, digits):
+    return f"{value:.{digits}f}"
+
+
+class FirmwareEmulator:
+    """One emulated robot behind a pty. Robot state mirrors robot.cpp."""
+
+    def __init__(self, name="robot0"):
+        self.name = name
+        self.master, self.slave = pty.openpty()
+        tty.setraw(self.slave)
+        self.path = os.ttyname(self.slave)
+
+        self.rx = b""
+        self.pending = None
+        self.dropped = 0                # Lines to answer with LINE_DROPPED
+        self.discarding = False         # Skipping the rest of a dropped line
+        self.checked_lines = 0          # Lines behind pending checked for a halt
+        self.running = True
+
+        # Reply output (SerialReplyWriter): bytes not yet on the wire
+        self.tx = []
+        self.tx_count = 0
+        self.deferred = None  # Unsolicited reply waiting for room (one slot)
+        self.tx_ready = threading.Condition()
+
+        # Robot state
+        self.state = "Halting"
+        self.direction = None
+        self.x = self.y = self.z = 0
+        self.liquid_um = 0                     # liquid held, µm of plunger travel
+        self.air_gap_um = 0
+        self.blowout_um = 0
+
+        # Pipetting: remaining phases of the request (see start_pipette)
+        self.pipette = []
+        self.liquid_classes = dict(DEFAULT_LIQUID_CLASSES)
+        self.active_liquid = "default"
+
+        # Jog
+        self.jog_axis = None
+        self.jog_velocity = 0
+        self.jog_target = 0
+        self.jog_keepalive_at = 0.0
+
+        # G-code
+        self.queue = []
+        self.relative = False
+        self.feed = 10000
+        self.plan = [0, 0, 0]
+        self.plan_volume = [0, 0, 0]           # liquid ticks, air gap µm, blowout µm
+        self.traverse = None
+        self.dwell_until = 0.0
+        self.deck = DeckModel()
+        self.hop = None
+
+        # Mix
+        self.mix = None
+        self.event = None
+
+        self.thread = threading.Thread(target=self._run, name=f"emu-{name}", daemon=True)
+        self.tx_thread = threading.Thread(target=self._transmit, name=f"emu-{name}-tx", daemon=True)
+
+    def start(self):
+        self.thread.start()
+        self.tx_thread.start()
+        return self
+
+    def stop(self):
+        self.running = False
+
+    # ---- serial I/O ----
+
+    def _transmit(self):
+        # The UART: the host sees each line once it is on the wire
+        while self.running:
+            with self.tx_ready:
+                while not self.tx:
+                    self.tx_ready.wait()
+                data = self.tx.pop(0)
+            time.sleep(len(data) * CHAR_TIME_S)
+            os.write(self.master, data)
+            with self.tx_ready:
+                self.tx_count -= len(data)
+
+    def _ring_room(self):
+        return TX_BUFFER_SIZE + HW_TX_BUFFER_SIZE - self.tx_count >= MAX_REPLY_LENGTH
+
+    def _tx_room(self):
+        return self.deferred is None and self._ring_room()
+
+    def _flush_deferred(self):
+        # SerialReplyWriter::poll: the waiting reply goes out once it fits
+        if self.deferred is not None and self._ring_room():
+            text, self.deferred = self.deferred, None
+            self._queue_reply(text)
+
+    def _queue_reply(self, text):
+        with self.tx_ready:
+            for line in text.split("\n"):
+                data = (line + "\r\n").encode()
+                self.tx.append(data)
+                self.tx_count += len(data)
+            self.tx_ready.notify()
+
+    def _poll(self, timeout):
+        if select.select([self.master], [], [], timeout)[0]:
+            try:
+                data = os.read(self.master, 256)
+            except OSError:
+                return
+            # Real-time halt: acted on immediately, drops buffered lines
+            *before, data = data.split(REALTIME_HALT)
+            for chunk in before:
+                self._receive(chunk)
+                self.dropped += self.rx.count(b"\n")
+                if self.rx and not self.rx.endswith(b"\n"):
+                    self.discarding = True
+                self.rx = b""
+                self._reply(self.fetch("HALT"))
+                if self.pending is not None:
+                    self.pending = None
+                    self.dropped += 1
+            self._receive(data)
+
+    def _receive(self, data):
+        if self.discarding:
+            if b"\n" not in data:
+                return
+            data = data.split(b"\n", 1)[1]
+            self.discarding = False
+            self.dropped += 1
+        # Bytes beyond the ring plus the hardware buffer are lost,
+        # exactly like an overrun UART (newest bytes are dropped)
+        room = RX_BUFFER_SIZE + HW_RX_BUFFER_SIZE - len(self.rx)
+        self.rx += data[:max(0, room)]
+        # A full ring without a newline is an overlong line: drop the rest too
+        if len(self.rx) >= RX_BUFFER_SIZE and b"\n" not in self.rx[:RX_BUFFER_SIZE]:
+            rest, self.rx = self.rx[RX_BUFFER_SIZE:], b""
+            self.discarding = True
+            self._receive(rest)
+
+    @staticmethod
+    def _line(raw):
+        """Decoded line, or None if it is longer than MAX_LINE_LENGTH."""
+        line = raw.replace(b"\r", b"").decode(errors="ignore")
+        return line if len(line) <= MAX_LINE_LENGTH else None
+
+    def is_halt_line(self, line):
+        """Lines that halt the robot: HALT, M112 and unknown plain text."""
+        if self.is_gcode(line):
+            cmd = self.parse_gcode(line)
+            return cmd is not None and cmd["code"] == "M112"
+        return line.split(" ")[0] not in PLAIN_WORDS
+
+    def _skip_to_halt(self):
+        # A halt line does not wait behind a blocked one (see loop() in the sketch)
+        lines = self.rx.split(b"\n")[:-1]
+        for i in range(self.checked_lines, len(lines)):
+            line = self._line(lines[i])
+            if line is not None and self.is_halt_line(line.strip()):
+                self.pending = None
+                self._reply(LINE_DROPPED)
+                self.rx = self.rx.split(b"\n", i)[-1]
+                self.dropped += i
+                return
+        self.checked_lines = len(lines)
+
+    def _reply(self, text):
+        """SerialReplyWriter::send: never waits. Without room (only unsolicited
+        replies get here) the reply waits in a single slot; a newer one replaces
+        it, except that an event never replaces a halt answer."""
+        if not text:
+            return
+        self._flush_deferred()
+        if not self._tx_room():
+            if self.deferred is None or not text.startswith("#") or self.deferred.startswith("#"):
+                self.deferred = text
+            return
+        self._queue_reply(text)
+
+    def _run(self):
+        while self.running:
+            busy = self.state != "Halting" or self.queue
+            self._poll(0 if busy else 0.005)
+            self._flush_deferred()
+
+            if self.pending is not None and self._tx_room():
+                self._skip_to_halt()
+
+            # Dropped lines are answered in order, one reply each
+            while self.pending is None and self.dropped and self._tx_room():
+                self.dropped -= 1
+                self._reply(LINE_DROPPED)
+
+            if self.pending is None and not self.dropped and b"\n" in self.rx:
+                raw, self.rx = self.rx.split(b"\n", 1)
+                line = self._line(raw)
+                if line is None:
+                    self.dropped += 1
+                elif line.strip():
+                    self.pending = line.strip()
+                    self.checked_lines = 0
+
+            if self.pending is not None and self._tx_room() and self.can_accept(self.pending):
+                line, self.pending = self.pending, None
+                self._reply(self.fetch(line))
+
+            duration = self.update()
+            if duration > 0:
+                time.sleep(duration)
+
+            # Events sent from update() (e.g. "#Mix done")
+            if self.event is not None:
+                event, self.event = self.event, None
+                self._reply(event)
+
+    # ---- command handling (robot.cpp: fetch) ----
+
+    def idle(self):
+        return self.state == "Halting" and not self.queue
+
+    def halt(self):
+        # A mix or stroke stopped half way is booked as it was moved
+        if self.state == "Mixing":
+            self.liquid_um += self.mix["pos"]
+        if self.state == "Pipetting" and self.pipette and self.pipette[0]["kind"] == "stroke":
+            self.book_stroke(self.pipette[0], self.pipette[0]["done"])
+        if self.state == "Pipetting" and self.pipette and self.pipette[0]["kind"] == "backlash":
+            # Out by what went forward and has not come back yet
+            done = self.pipette[0]["done"]
+            self.liquid_um += min(done, 2 * UM_PER_TICK - done)
+        self.pipette = []
+        self.state = "Halting"
+        self.direction = None
+        self.jog_velocity = self.jog_target = 0
+
+    @staticmethod
+    def is_gcode(line):
+        return bool(re.match(r"^([GMN]\s*[-\d]|[;(])", line, re.IGNORECASE))
+
+    def can_accept(self, line):
+        if not self.is_gcode(line):
+            return True
+        cmd = self.parse_gcode(line)
+        if cmd is None:
+            return True
+        code = cmd["code"]
+        if code in ("G0", "G1", "G4", "G92", "M701", "M702", "M703"):
+            return len(self.queue) < MOTION_QUEUE_SIZE
+        if code == "G28":
+            return len(self.queue) + 2 <= MOTION_QUEUE_SIZE
+        if code == "M400":
+            return self.idle()
+        return True
+
+    def fetch(self, line):
+        if self.is_gcode(line):
+            return self.fetch_gcode(line)
+
+        parts = line.split(" ")
+        word = parts[0]
+
+        if word in ("X+", "X-", "Y+", "Y-", "Z+", "Z-") and len(parts) == 1:
+            if self.idle():
+                self.state = "Moving"
+                self.direction = word
+                return f"Move {word}"
+            return ""
+        if line == "RELEASED":
+            if self.state == "Moving":
+                self.halt()
+                return "Halt Move"
+            if self.state == "Jogging":
+                self.jog_target = 0
+                return "Halt Move"
+            return ""
+        if word in ("PULL", "PUSH") and len(parts) >= 2 and self.known_liquid(parts, 2):
+            if not self.idle():
+                return ""
+            return self.start_pipette(word, atol(parts[1]), parts[2] if len(parts) > 2 else None)
+        if word == "MIX" and len(parts) >= 2 and self.known_liquid(parts, 5):
+            if not self.idle():
+                return ""
+            args = [atol(a) for a in parts[1:5]] + [1, 0, 0][len(parts[1:5]) - 1:]
+            return self.start_mix(*args[:4], parts[5] if len(parts) > 5 else None)
+        if word == "LIQUID" and len(parts) == 2 and parts[1] in self.liquid_classes:
+            self.active_liquid = parts[1]
+            return f"Liquid {parts[1]}"
+        if word == "LIQUID" and len(parts) > 2 and len(parts[1]) <= LIQUID_CLASS_NAME_LENGTH:
+            name = parts[1]
+            fields = list(self.liquid_classes.get(name, DEFAULT_LIQUID_CLASSES["default"]))
+            fields[:len(parts) - 2] = [atol(a) for a in parts[2:8]]
+            if fields[0] > 0 and fields[1] > 0:
+                if name not in self.liquid_classes and len(self.liquid_classes) == LIQUID_CLASS_COUNT:
+                    return f"Liquid {name} rejected (table full)"
+                self.liquid_classes[name] = tuple(fields)
+                return f"Liquid {name} set"
+        if word in ("DECK", "TIP") and len(parts) >= 2:
+            if word == "DECK":
+                self.deck.deck_z = atol(parts[1])
+            else:
+                self.deck.tip_length = atol(parts[1])
+            return f"{word.capitalize()} set"
+        if word == "LABWARE" and len(parts) >= 2 and 0 <= atol(parts[1]) < DECK_LABWARE_COUNT:
+            slot = atol(parts[1])
+            fields = ([atol(a) for a in parts[2:7]] + [0] * 5)[:5]
+            self.deck.labware[slot] = tuple(fields)
+            return f"Labware {slot} {'set' if fields[4] > 0 else 'cleared'}"
+        if word == "JOG" and len(parts) >= 2 and parts[1] in ("X", "Y", "Z"):
+            return self.fetch_jog(parts[1], atol(parts[2]) if len(parts) > 2 else 0,
+                                  len(parts) > 3 and parts[3] == "K")
+
+        # Unknown command → emergency halt
+        self.queue.clear()
+        self.halt()
+        return "Halt Robot"
+
+    def known_liquid(self, parts, index):
+        """False if parts names an unknown liquid class at index (parsed as halt)."""
+        return len(parts) <= index or parts[index] in self.liquid_classes
+
+    def liquid(self, name):
+        return self.liquid_classes[name or self.active_liquid]
+
+    @property
+    def syringe_pos(self):
+        """Liquid held in ticks (SyringeSystem::getCurrentPos)."""
+        return (self.liquid_um + UM_PER_TICK // 2) // UM_PER_TICK
+
+    def used_um(self):
+        return self.liquid_um + self.air_gap_um + self.blowout_um
+
+    def start_pipette(self, word, ticks, liquid=None):
+        aspirate, dispense, accel, settle_ms, air_gap_ul, blowout_ul = self.liquid(liquid)
+        accel = ul_to_um(accel)
+        self.state = "Pipetting"
+
+        def stroke(kind, um, ul_per_s, ticks=0):
+            return {"kind": "stroke", "what": kind, "um": um, "done": 0, "v": 0, "ticks": ticks,
+                    "speed": max(1, min(SYRINGE_MAX_UM_PER_S, ul_to_um(ul_per_s))), "accel": accel}
+
+        settle = {"kind": "settle", "ms": settle_ms, "until": None}
+        if word == "PULL":
+            blowout = ul_to_um(blowout_ul) if self.syringe_pos == 0 and self.blowout_um == 0 else 0
+            air_gap = ul_to_um(air_gap_ul)
+            room = CAPACITY_TICKS * UM_PER_TICK - self.used_um()
+            if ticks < 0 or ticks * UM_PER_TICK + blowout + air_gap > room:
+                self.state = "Halting"
+                return "Pull request rejected"
+            self.pipette = []
+            if blowout:
+                self.pipette += [{"kind": "lift", "target": min(self.z + AIR_RETRACT_UM, 0)},
+                                 stroke("blowout", blowout, aspirate),
+                                 {"kind": "lift", "target": self.z}]
+            self.pipette += [stroke("pull", ticks * UM_PER_TICK, aspirate, ticks), settle]
+            if air_gap:
+                self.pipette += [{"kind": "lift", "target": None}, stroke("air gap", air_gap, aspirate)]
+            return f"Pull {fmt(ticks * MINIMUM_ML, 1)} ml"
+
+        reply = "Push All"
+        if ticks == -1:
+            ticks = self.syringe_pos
+        elif ticks < 0 or self.syringe_pos < ticks:
+            self.state = "Halting"
+            return "Push request rejected"
+        else:
+            reply = f"Push {fmt(ticks * MINIMUM_ML, 1)} ml"
+        # Air gap leaves first, blowout air last (when the syringe empties)
+        everything = ticks == self.syringe_pos
+        um = (self.liquid_um + self.blowout_um if everything else ticks * UM_PER_TICK) + self.air_gap_um
+        self.pipette = [stroke("push", um, dispense, ticks), settle]
+        return reply
+
+    def start_mix(self, ticks, cycles, ul_per_s, z_um, liquid=None):
+        room = CAPACITY_TICKS * UM_PER_TICK - self.used_um()
+        if ticks <= 0 or cycles <= 0 or ticks * UM_PER_TICK > room:
+            return "Mix request rejected"
+        aspirate, dispense = self.liquid(liquid)[:2]
+        if ul_per_s > 0:
+            aspirate = dispense = ul_per_s
+        pull, push = (max(1, min(SYRINGE_MAX_UM_PER_S, ul_to_um(f))) for f in (aspirate, dispense))
+        self.mix = {"cycles": cycles, "stroke": ticks * UM_PER_TICK, "pos": 0,
+                    "pulling": True, "pull": pull, "push": push, "z": z_um, "z_start": self.z}
+        self.state = "Mixing"
+        return f"Mix {fmt(ticks * MINIMUM_ML, 1)} ml x{cycles}"
+
+    def fetch_jog(self, axis, velocity, keepalive=False):
+        limit = LIFT_MAX_UM_PER_S if axis == "Z" else XY_MAX_UM_PER_S
+        target = max(-limit, min(limit, velocity))
+        running = self.state == "Jogging" and axis == self.jog_axis
+        if keepalive:
+            # Never starts motion, never revives a stopped jog, never answered
+            if running and self.jog_target != 0:
+                self.jog_target = target
+                self.jog_keepalive_at = time.monotonic()
+            return ""
+        if target == 0:
+            if running:
+                self.jog_target = 0
+            return "Stop Jog"
+        if self.idle() or running:
+            if not running:
+                self.state = "Jogging"
+                self.jog_axis = axis
+                self.jog_velocity = 0
+            self.jog_target = target
+            self.jog_keepalive_at = time.monotonic()
+            return f"Jog {axis}"
+        return ""
+
+    # ---- G-code (gcode.cpp) ----
+
+    @staticmethod
+    def parse_gcode(line):
+        words = {}
+        text = re.sub(r"\(.*?\)", " ", line.split(";", 1)[0].split("*", 1)[0].upper())
+        token = ""
+        for c in text + " ":
+            if c.isalpha() or c in " \t":
+                if token:
+                    try:
+                        words[token[0]] = float(token[1:])
+                    except ValueError:
+                        return None
+                token = c if c.isalpha() else ""
+            else:
+                token += c
+        words.pop("N", None)
+        if "G" in words:
+            return {"code": f"G{int(words['G'])}", **words}
+        if "M" in words:
+            return {"code": f"M{int(words['M'])}", **words}
+        return {"code": "NOP"}
+
+    def plan_pipette(self, word, ticks, index):
+        """Robot::planPipette(): book a queued request against the planned contents."""
+        liquid_ticks, air_gap, blowout = self.plan_volume
+        if word == "PUSH":
+            ticks = liquid_ticks if ticks == -1 else ticks
+            if not 0 <= ticks <= liquid_ticks:
+                return False
+            liquid_ticks -= ticks
+            self.plan_volume = [liquid_ticks, 0, blowout if liquid_ticks else 0]
+            return True
+        _, _, _, _, air_gap_ul, blowout_ul = self.liquid(self.liquid_name(index))
+        draw_blowout = ul_to_um(blowout_ul) if liquid_ticks == 0 and blowout == 0 else 0
+        used = (liquid_ticks + ticks) * UM_PER_TICK + air_gap + blowout + draw_blowout + ul_to_um(air_gap_ul)
+        if ticks < 0 or used > CAPACITY_TICKS * UM_PER_TICK:
+            return False
+        self.plan_volume = [liquid_ticks + ticks, air_gap + ul_to_um(air_gap_ul), blowout + draw_blowout]
+        return True
+
+    def liquid_name(self, index):
+        """Liquid class name for a G-code L index (None = the selected class)."""
+        if index is None:
+            return None
+        names = list(self.liquid_classes)
+        return names[int(index)] if int(index) < len(names) else "default"
+
+    def position_report(self):
+        return (f"X:{fmt(self.x / 1000, 3)} Y:{fmt(self.y / 1000, 3)} "
+                f"Z:{fmt(self.z / 1000, 3)} V:{fmt(self.syringe_pos * MINIMUM_ML, 1)}")
+
+    def fetch_gcode(self, line):
+        if self.idle():
+            self.plan = [self.x, self.y, self.z]
+            self.plan_volume = [self.syringe_pos, self.air_gap_um, self.blowout_um]
+
+        cmd = self.parse_gcode(line)
+        if cmd is None:
+            return "error: unsupported command"
+        code = cmd["code"]
+        axes = [a for a in "XYZ" if a in cmd]
+        values = {a: round(cmd[a] * 1000) for a in axes}
+        reply = ""
+
+        if code in ("G0", "G1", "M703"):
+            target = [self.plan[i] + values.get(a, 0) if self.relative else values.get(a, self.plan[i])
+                      for i, a in enumerate("XYZ")]
+            # Labware too tall to clear at the top of travel rejects a hop
+            if code == "M703" and self.deck.clearance(self.plan[:2], target[:2], 0.0, 1.0) > 0:
+                return "error: hop path too tall to clear"
+            self.plan = target
+            if code == "M703":
+                self.queue.append(("hop", list(self.plan)))
+                return "ok"
+            if "F" in cmd:
+                self.feed = round(cmd["F"] * 1000 / 60)
+            self.queue.append(("move", list(self.plan), code == "G0", self.feed))
+        elif code == "G4":
+            ms = cmd.get("P", cmd.get("S", 0) * 1000)
+            self.queue.append(("dwell", ms))
+        elif code == "G28":
+            axes = axes or ["X", "Y", "Z"]
+            if "Z" in axes:
+                self.plan[2] = 0
+                self.queue.append(("move", list(self.plan), True, 0))
+            if "X" in axes or "Y" in axes:
+                if "X" in axes:
+                    self.plan[0] = 0
+                if "Y" in axes:
+                    self.plan[1] = 0
+                self.queue.append(("move", list(self.plan), True, 0))
+        elif code == "G92":
+            values = values or {"X": 0, "Y": 0, "Z": 0}
+            for i, a in enumerate("XYZ"):
+                if a in values:
+                    self.plan[i] = values[a]
+            self.queue.append(("set", list(self.plan)))
+        elif code in ("G90", "G91"):
+            self.relative = code == "G91"
+        elif code == "M112":
+            self.queue.clear()
+            self.halt()
+            reply = "Halt Robot\n"
+        elif code == "M114":
+            reply = self.position_report() + "\n"
+        elif code in ("M701", "M702") and not 0 <= cmd.get("L", 0) < len(self.liquid_classes):
+            return "error: unsupported command"
+        elif code == "M701" and "V" in cmd:
+            item = ("pipette", "PULL", round(cmd["V"] / MINIMUM_ML), cmd.get("L"))
+            if not self.plan_pipette(*item[1:]):
+                return "error: syringe volume out of range"
+            self.queue.append(item)
+        elif code == "M702":
+            item = ("pipette", "PUSH", round(cmd["V"] / MINIMUM_ML) if "V" in cmd else -1, cmd.get("L"))
+            if not self.plan_pipette(*item[1:]):
+                return "error: syringe volume out of range"
+            self.queue.append(item)
+        elif code not in ("G21", "M400", "NOP"):
+            return "error: unsupported command"
+
+        return reply + "ok"
+
+    # ---- motion (robot.cpp: update), returns blocking time in seconds ----
+
+    def update(self):
+        if self.state == "Halting":
+            if self.queue:
+                self.start_queued()
+            return 0
+        if self.state == "Moving":
+            return self.update_move()
+        if self.state == "Pipetting":
+            return self.update_pipette()
+        if self.state == "Jogging":
+            return self.update_jog()
+        if self.state == "Mixing":
+            return self.update_mix()
+        if self.state == "Traversing":
+            return self.update_traverse()
+        if self.state == "Hopping":
+            return self.update_hop()
+        if self.state == "Dwelling":
+            if time.monotonic() >= self.dwell_until:
+                self.state = "Halting"
+            return 0
+        return 0
+
+    def update_move(self):
+        # One motion slice at the maximum speed (Robot::xyMoveSlice/liftMoveSlice)
+        sign = 1 if self.direction[1] == "+" else -1
+        xy = min(XY_UM_PER_MOVE, XY_MAX_UM_PER_S * MOTION_SLICE_MS // 1000)
+        lift = min(LIFT_UM_PER_MOVE, LIFT_MAX_UM_PER_S * MOTION_SLICE_MS // 1000)
+        if self.direction[0] == "X":
+            self.x += sign * xy
+            return move_time_s(xy, BELT_UM_PER_STEP, XY_MAX_UM_PER_S)
+        if self.direction[0] == "Y":
+            self.y += sign * xy
+            return move_time_s(xy, BELT_UM_PER_STEP, XY_MAX_UM_PER_S)
+        self.z += sign * lift
+        return move_time_s(lift, SCREW_UM_PER_STEP, LIFT_MAX_UM_PER_S)
+
+    def book_stroke(self, step, um):
+        """Account for um of a stroke's travel (SyringeSystem::finishStroke/cancel)."""
+        if step["what"] == "pull":
+            self.liquid_um += um
+        elif step["what"] == "blowout":
+            self.blowout_um += um
+        elif step["what"] == "air gap":
+            self.air_gap_um += um
+        else:
+            air = min(um, self.air_gap_um)
+            self.air_gap_um -= air
+            liquid = min(um - air, self.liquid_um)
+            self.liquid_um -= liquid
+            self.blowout_um -= min(um - air - liquid, self.blowout_um)
+
+    def update_pipette(self):
+        if not self.pipette:
+            self.halt()
+            return 0
+        step = self.pipette[0]
+
+        if step["kind"] == "lift":
+            if step["target"] is None:
+                step["target"] = min(self.z + AIR_RETRACT_UM, 0)
+            um = max(-LIFT_MAX_UM_PER_S * MOTION_SLICE_MS // 1000,
+                     min(LIFT_MAX_UM_PER_S * MOTION_SLICE_MS // 1000, step["target"] - self.z))
+            self.z += um
+            if self.z == step["target"]:
+                self.pipette.pop(0)
+            return move_time_s(um, SCREW_UM_PER_STEP, LIFT_MAX_UM_PER_S)
+
+        if step["kind"] == "backlash":
+            # adjustPosition(): one tick forward and back, a slice at a time
+            um = max(1, SCREW_UM_PER_STEP * 500000 // PULSE_WIDTH_US * MOTION_SLICE_MS // 1000)
+            um = min(um, (UM_PER_TICK if step["done"] < UM_PER_TICK else 2 * UM_PER_TICK) - step["done"])
+            step["done"] += um
+            if step["done"] >= 2 * UM_PER_TICK:
+                self.pipette.pop(0)
+            return move_time_s(um, SCREW_UM_PER_STEP)
+
+        if step["kind"] == "settle":
+            if step["until"] is None:
+                step["until"] = time.monotonic() + step["ms"] / 1000
+            if time.monotonic() >= step["until"]:
+                self.pipette.pop(0)
+            return 0
+
+        # Trapezoidal stroke (SyringeSystem::advance)
+        left = step["um"] - step["done"]
+        if left <= 0:
+            self.pipette.pop(0)
+            if step["what"] == "push":
+                self.liquid_um = max(self.liquid_um - (step["um"] - self.air_gap_um), 0)
+                self.air_gap_um = 0
+                if self.liquid_um == 0:
+                    self.blowout_um = 0
+                return 0
+            self.book_stroke(step, step["um"])
+            if step["what"] == "pull":
+                self.pipette.insert(0, {"kind": "backlash", "done": 0})
+            return 0
+        v = step["speed"]
+        if step["accel"] > 0:
+            v = min(v, step["v"] + step["accel"] * MOTION_SLICE_MS // 1000)
+            v = max(1, min(v, int(math.sqrt(2 * step["accel"] * left))))
+        step["v"] = v
+        um = min(max(1, v * MOTION_SLICE_MS // 1000), left)
+        step["done"] += um
+        return move_time_s(um, SCREW_UM_PER_STEP, v)
+
+    def update_mix(self):
+        m = self.mix
+        speed = m["pull"] if m["pulling"] else m["push"]
+        um = max(1, speed * MOTION_SLICE_MS // 1000)
+        um = min(um, m["stroke"] - m["pos"] if m["pulling"] else m["pos"])
+        m["pos"] += um if m["pulling"] else -um
+        duration = move_time_s(um, SCREW_UM_PER_STEP, speed)
+        if m["z"]:
+            z = m["z_start"] - round(m["pos"] / m["stroke"] * m["z"])
+            duration += move_time_s(z - self.z, SCREW_UM_PER_STEP, LIFT_MAX_UM_PER_S)
+            self.z = z
+        if m["pulling"] and m["pos"] >= m["stroke"]:
+            m["pulling"] = False
+        elif not m["pulling"] and m["pos"] <= 0:
+            m["pulling"] = True
+            m["cycles"] -= 1
+            if m["cycles"] == 0:
+                self.halt()
+                self.event = "#Mix done"
+        return duration
+
+    def update_jog(self):
+        if (time.monotonic() - self.jog_keepalive_at) * 1000 > JOG_KEEPALIVE_MS:
+            self.jog_target = 0
+        accel = LIFT_JOG_ACCEL if self.jog_axis == "Z" else XY_JOG_ACCEL
+        dv = accel * MOTION_SLICE_MS // 1000
+        if self.jog_velocity < self.jog_target:
+            self.jog_velocity = min(self.jog_velocity + dv, self.jog_target)
+        elif self.jog_velocity > self.jog_target:
+            self.jog_velocity = max(self.jog_velocity - dv, self.jog_target)
+        if self.jog_velocity == 0 and self.jog_target == 0:
+            self.halt()
+            return 0
+
+        um = int(self.jog_velocity * MOTION_SLICE_MS / 1000)
+        per_step = SCREW_UM_PER_STEP if self.jog_axis == "Z" else BELT_UM_PER_STEP
+        setattr(self, self.jog_axis.lower(), getattr(self, self.jog_axis.lower()) + um)
+        return move_time_s(um, per_step, abs(self.jog_velocity))
+
+    def start_queued(self):
+        item = self.queue.pop(0)
+        if item[0] == "move":
+            _, target, rapid, feed = item
+            start = [self.x, self.y, self.z]
+            delta = [t - s for t, s in zip(target, start)]
+            length = sum(abs(d) for d in delta)
+            if length == 0:
+                return
+            # Each axis at its own limit; a feed slows both (Robot::beginLinear)
+            xy_speed = XY_RAPID_UM_PER_S if rapid else XY_MAX_UM_PER_S
+            lift_speed = LIFT_RAPID_UM_PER_S if rapid else LIFT_MAX_UM_PER_S
+            if not rapid:
+                path = math.sqrt(sum(d * d for d in delta))
+                speed = max(1, round(feed * length / path))
+                xy_speed, lift_speed = min(xy_speed, speed), min(lift_speed, speed)
+            ms = (abs(delta[0]) + abs(delta[1])) * 1000 / xy_speed + abs(delta[2]) * 1000 / lift_speed
+            self.traverse = {"start": start, "delta": delta, "length": length, "done": 0,
+                             "step": max(1, round(length * MOTION_SLICE_MS / ms)),
+                             "xy_speed": xy_speed, "lift_speed": lift_speed}
+            self.state = "Traversing"
+        elif item[0] == "hop":
+            start, target = (self.x, self.y), item[1]
+            path = math.hypot(target[0] - start[0], target[1] - start[1])
+            self.hop = {"start": start, "end": (target[0], target[1]), "z": target[2],
+                        "f": 0.0 if path else 1.0,
+                        "df": XY_RAPID_UM_PER_S * MOTION_SLICE_MS // 1000 / path if path else 1.0}
+            self.state = "Hopping"
+        elif item[0] == "dwell":
+            self.dwell_until = time.monotonic() + item[1] / 1000
+            self.state = "Dwelling"
+        elif item[0] == "set":
+            self.x, self.y, self.z = item[1]
+        elif item[0] == "pipette":
+            self.start_pipette(item[1], item[2], self.liquid_name(item[3]))
+
+    def update_traverse(self):
+        t = self.traverse
+        t["done"] = min(t["length"], t["done"] + t["step"])
+        f = t["done"] / t["length"]
+        point = [s + round(d * f) for s, d in zip(t["start"], t["delta"])]
+        duration = (move_time_s(point[0] - self.x, BELT_UM_PER_STEP, t["xy_speed"])
+                    + move_time_s(point[1] - self.y, BELT_UM_PER_STEP, t["xy_speed"])
+                    + move_time_s(point[2] - self.z, SCREW_UM_PER_STEP, t["lift_speed"]))
+        self.x, self.y, self.z = point
+        if t["done"] >= t["length"]:
+            self.halt()
+        return duration
+
+    def update_hop(self):
+        h = self.hop
+        z_goal = h["z"]
+        if h["f"] < 1:
+            clear = self.deck.clearance(h["start"], h["end"], h["f"], 1.0)
+            if clear > 0:
+                # Labware added after the hop was queued is out of reach
+                self.queue.clear()
+                self.halt()
+                self.event = "#Hop too tall, queue cleared"
+                return 0
+            z_goal = max(z_goal, clear)
+        step = LIFT_RAPID_UM_PER_S * MOTION_SLICE_MS // 1000
+        dz = max(-step, min(step, z_goal - self.z))
+        self.z += dz
+        duration = move_time_s(dz, SCREW_UM_PER_STEP, LIFT_RAPID_UM_PER_S)
+
+        if h["f"] < 1:
+            h["f"] = self.deck.reach(h["start"], h["end"], h["f"], min(h["f"] + h["df"], 1.0), self.z)
+            x = h["start"][0] + round((h["end"][0] - h["start"][0]) * h["f"])
+            y = h["start"][1] + round((h["end"][1] - h["start"][1]) * h["f"])
+            duration += (move_time_s(x - self.x, BELT_UM_PER_STEP, XY_RAPID_UM_PER_S)
+                         + move_time_s(y - self.y, BELT_UM_PER_STEP, XY_RAPID_UM_PER_S))
+            self.x, self.y = x, y
+
+        if h["f"] >= 1 and self.z == h["z"]:
+            self.halt()
+        return duration
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pseudo-terminal pipette robot emulator")
+    parser.add_argument("-n", "--count", type=int, default=1, help="number of robots")
+    args = parser.parse_args()
+
+    robots = [FirmwareEmulator(f"robot{i}").start() for i in range(args.count)]
+    print(" ".join(f"{r.name}={r.path}" for r in robots), flush=True)
+
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,382 @@
+import itertools
+import queue
+import re
+import threading
+import time
+from collections import deque
+
+import serial
+
+# Serial settings shared by every robot (must match Serial.begin() in the firmware)
+BAUD_RATE = 9600
+READ_TIMEOUT_S = 1
+
+# How long a job step keeps retrying while the robot is still busy with the previous one
+BUSY_RETRY_INTERVAL_S = 0.2
+BUSY_RETRY_TIMEOUT_S = 120
+
+# Jog keepalives that waited longer than this behind other requests are
+# dropped: the firmware deadman (250 ms) has to see the gap, not a burst
+KEEPALIVE_MAX_AGE_S = 0.2
+
+# Number of exchanged lines kept per robot for monitoring
+LOG_LENGTH = 50
+
+# Request priorities (lower value is served first)
+PRIORITY_HALT = 0
+PRIORITY_NORMAL = 1
+
+# Unsolicited firmware events ("#Mix done") start with this; they are never a reply
+EVENT_PREFIX = "#"
+
+# Replies that end a job step unsuccessfully ("Pull request rejected",
+# "error: ...", "Halt Robot" for a halted or unknown line)
+FAILED_REPLY = re.compile(r"^(error: .*|.* rejected\b.*|Halt Robot)$")
+
+# Replies such as "Pull 1.0 ml" / "Push 0.4 ml" update the host-side volume model
+VOLUME_REPLY = re.compile(r"^(Pull|Push) (\d+(?:\.\d+)?) ml$")
+
+
+def parse_robot_specs(specs):
+    """Turn ["bench1=/dev/ttyACM0", "/dev/ttyACM1"] into an ordered {name: port} dict."""
+    robots = {}
+    for index, spec in enumerate(specs):
+        if "=" in spec:
+            name, port = spec.split("=", 1)
+        else:
+            name, port = f"robot{index}", spec
+        robots[name.strip()] = port.strip()
+    return robots
+
+
+def needs_idle(cmd):
+    """True for commands the firmware only accepts while Halting (it stays silent otherwise)."""
+    return cmd in ("X+", "X-", "Y+", "Y-", "Z+", "Z-") or cmd.startswith(("PULL ", "PUSH ", "MIX "))
+
+
+class Request:
+    """One line to send to a robot, completed by its serial worker."""
+
+    def __init__(self, cmd, expect_reply=True):
+        self.cmd = cmd
+        self.expect_reply = expect_reply
+        self.reply = None
+        self.error = None
+        self.done = threading.Event()
+
+    def wait(self, timeout=None):
+        """Block until the worker has handled the request and return the reply line."""
+        if not self.done.wait(timeout):
+            raise TimeoutError(f"No answer for '{self.cmd}'")
+        if self.error is not None:
+            raise self.error
+        return self.reply
+
+
+class RobotWorker:
+    """Owns one serial port: a thread serializes all exchanges and keeps a state model."""
+
+    def __init__(self, name, port, baud_rate=BAUD_RATE):
+        self.name = name
+        self.port = port
+        self.baud_rate = baud_rate
+        self.ser = None
+
+        # (priority, sequence, Request): halts overtake queued commands
+        self.requests = queue.PriorityQueue()
+        self.sequence = itertools.count()
+
+        # State model (guarded by lock, read by the API)
+        self.lock = threading.Lock()
+        self.job = None
+        self.last_sent = ""
+        self.last_reply = ""
+        self.last_event = ""
+        self.aspirated_ml = 0.0
+        self.log = deque(maxlen=LOG_LENGTH)
+
+        # Newest jog keepalive not sent yet: (line, submitted at)
+        self.pending_keepalive = None
+
+        self.thread = threading.Thread(target=self._run, name=f"robot-{name}", daemon=True)
+
+    def open(self):
+        """Open the serial port (errors are reported, the robot stays offline)."""
+        try:
+            self.ser = serial.Serial(self.port, self.baud_rate, timeout=READ_TIMEOUT_S)
+            print(f"[{self.name}] Serial initialized on {self.port} ({self.baud_rate} baud)", flush=True)
+        except Exception as e:
+            print(f"[{self.name}] Failed to open {self.port}: {e}", flush=True)
+            self.ser = None
+
+    def start(self):
+        self.open()
+        self.thread.start()
+
+    @property
+    def connected(self):
+        return self.ser is not None and self.ser.is_open
+
+    @property
+    def idle(self):
+        """Idle robots are connected and not running a scheduled job."""
+        with self.lock:
+            return self.connected and self.job is None
+
+    def submit(self, cmd, expect_reply=True, priority=PRIORITY_NORMAL):
+        """Queue a line for the serial worker and return its Request."""
+        req = Request(cmd, expect_reply)
+        self.requests.put((priority, next(self.sequence), req))
+        return req
+
+    def keepalive(self, cmd):
+        """Queue a fire-and-forget jog keepalive; it replaces one still waiting."""
+        with self.lock:
+            queued = self.pending_keepalive is not None
+            self.pending_keepalive = (cmd, time.monotonic())
+        if not queued:
+            # Placeholder request, the line is picked up when it is served
+            self.submit(None, expect_reply=False)
+
+    def send(self, cmd, priority=PRIORITY_NORMAL):
+        """Send a line and wait for the one-line reply."""
+        return self.submit(cmd, priority=priority).wait(timeout=READ_TIMEOUT_S + 30)
+
+    def halt(self):
+        """Emergency stop: cancel the running job and jump the request queue."""
+        with self.lock:
+            if self.job is not None:
+                self.job.cancel()
+        return self.send("HALT", priority=PRIORITY_HALT)
+
+    def snapshot(self):
+        """JSON-friendly view of the state model."""
+        with self.lock:
+            return {
+                "name": self.name,
+                "port": self.port,
+                "connected": self.connected,
+                "busy": self.job is not None,
+                "job": self.job.id if self.job is not None else None,
+                "queued": self.requests.qsize(),
+                "last_sent": self.last_sent,
+                "last_reply": self.last_reply,
+                "last_event": self.last_event,
+                "aspirated_ml": round(self.aspirated_ml, 1),
+                "log": list(self.log),
+            }
+
+    def _run(self):
+        while True:
+            _, _, req = self.requests.get()
+            try:
+                if req.cmd is None:
+                    req.reply = self._send_keepalive()
+                else:
+                    req.reply = self._exchange(req.cmd, req.expect_reply)
+            except Exception as e:
+                req.error = e
+            req.done.set()
+
+    def _send_keepalive(self):
+        with self.lock:
+            cmd, submitted = self.pending_keepalive
+            self.pending_keepalive = None
+        if time.monotonic() - submitted > KEEPALIVE_MAX_AGE_S:
+            return ""
+        return self._exchange(cmd, False)
+
+    def _exchange(self, cmd, expect_reply):
+        if not self.connected:
+            raise ConnectionError("Serial port is not open.")
+
+        reply = ""
+        if expect_reply:
+            # Clear stale input before sending a new command (events still count)
+            self._drain_input()
+
+        self.ser.write((cmd + "\n").encode("utf-8"))
+        self.ser.flush()
+
+        if expect_reply:
+            # Events can arrive ahead of the reply; they go to the state model
+            while True:
+                reply = self.ser.readline().decode("utf-8", errors="ignore").strip()
+                if not reply.startswith(EVENT_PREFIX):
+                    break
+                self._record_event(reply)
+            # Fire-and-forget lines (jog keepalives) would flood the log
+            self._record(cmd, reply)
+
+        return reply
+
+    def _drain_input(self):
+        stale = self.ser.read(self.ser.in_waiting).decode("utf-8", errors="ignore")
+        for line in stale.splitlines():
+            if line.strip().startswith(EVENT_PREFIX):
+                self._record_event(line.strip())
+
+    def _record_event(self, event):
+        with self.lock:
+            self.last_event = event
+            self.log.append(f"< {event}")
+
+    def _record(self, cmd, reply):
+        with self.lock:
+            self.last_sent = cmd
+            self.log.append(f"> {cmd}")
+            if reply:
+                self.last_reply = reply
+                self.log.append(f"< {reply}")
+
+            # Track aspirated volume from the firmware's confirmations
+            match = VOLUME_REPLY.match(reply)
+            if match:
+                ml = float(match.group(2))
+                self.aspirated_ml += ml if match.group(1) == "Pull" else -ml
+            elif reply == "Push All":
+                self.aspirated_ml = 0.0
+
+
+class Job:
+    """A protocol: device lines and waits, run in order on one robot.
+
+    steps : list of {"command": "PULL 5"} or {"wait": seconds}
+    robot : optional robot name the job is pinned to
+    """
+
+    ids = itertools.count(1)
+
+    def __init__(self, steps, robot=None):
+        self.id = next(Job.ids)
+        self.steps = steps
+        self.robot = robot
+        self.status = "queued"
+        self.assigned = None
+        self.step = 0
+        self.error = None
+        self.cancelled = threading.Event()
+
+    def cancel(self):
+        self.cancelled.set()
+
+    def snapshot(self):
+        return {
+            "id": self.id,
+            "status": self.status,
+            "robot": self.assigned or self.robot,
+            "step": self.step,
+            "steps": len(self.steps),
+            "error": self.error,
+        }
+
+
+class Fleet:
+    """Registry of robots plus a scheduler spreading queued jobs across idle robots."""
+
+    def __init__(self, robots):
+        # robots : ordered {name: port}
+        self.robots = {name: RobotWorker(name, port) for name, port in robots.items()}
+        self.jobs = []
+        self.pending = deque()
+        self.lock = threading.Lock()
+        self.wakeup = threading.Event()
+        self.scheduler = threading.Thread(target=self._schedule, name="scheduler", daemon=True)
+
+    def start(self):
+        for robot in self.robots.values():
+            robot.start()
+        self.scheduler.start()
+
+    def get(self, name=None):
+        """Look up a robot by name; None selects the first configured robot."""
+        if name is None:
+            return next(iter(self.robots.values()))
+        return self.robots.get(name)
+
+    def submit_job(self, steps, robot=None):
+        job = Job(steps, robot)
+        with self.lock:
+            self.jobs.append(job)
+            self.pending.append(job)
+        self.wakeup.set()
+        return job
+
+    def cancel_job(self, job_id):
+        with self.lock:
+            for job in self.jobs:
+                if job.id == job_id:
+                    job.cancel()
+                    if job in self.pending:
+                        self.pending.remove(job)
+                        job.status = "cancelled"
+                    return job
+        return None
+
+    def snapshot(self):
+        return [robot.snapshot() for robot in self.robots.values()]
+
+    def job_snapshot(self):
+        with self.lock:
+            return [job.snapshot() for job in self.jobs]
+
+    def _schedule(self):
+        # Hand each pending job (oldest first) to the first idle robot it may run on
+        while True:
+            self.wakeup.wait(timeout=0.5)
+            self.wakeup.clear()
+            with self.lock:
+                for job in list(self.pending):
+                    robot = self._pick_robot(job)
+                    if robot is None:
+                        continue
+                    self.pending.remove(job)
+                    with robot.lock:
+                        robot.job = job
+                    job.assigned = robot.name
+                    job.status = "running"
+                    threading.Thread(target=self._run_job, args=(robot, job), daemon=True).start()
+
+    def _pick_robot(self, job):
+        if job.robot is not None:
+            robot = self.robots.get(job.robot)
+            return robot if robot is not None and robot.idle else None
+        for robot in self.robots.values():
+            if robot.idle:
+                return robot
+        return None
+
+    def _run_job(self, robot, job):
+        try:
+            for index, step in enumerate(job.steps):
+                job.step = index
+                if job.cancelled.is_set():
+                    job.status = "cancelled"
+                    return
+                if "wait" in step:
+                    job.cancelled.wait(float(step["wait"]))
+                    continue
+                self._run_step(robot, job, step["command"])
+            job.step = len(job.steps)
+            job.status = "cancelled" if job.cancelled.is_set() else "done"
+        except Exception as e:
+            job.status = "failed"
+            job.error = str(e)
+        finally:
+            with robot.lock:
+                robot.job = None
+            self.wakeup.set()
+
+    def _run_step(self, robot, job, cmd):
+        # The firmware ignores new motion while busy, so retry until it is accepted
+        deadline = time.monotonic() + BUSY_RETRY_TIMEOUT_S
+        while True:
+            reply = robot.send(cmd)
+            if FAILED_REPLY.match(reply):
+                raise RuntimeError(f"{robot.name} answered '{cmd}' with '{reply}'")
+            if reply != "" or not needs_idle(cmd):
+                return reply
+            if time.monotonic() > deadline:
+                raise TimeoutError(f"{robot.name} stayed busy, '{cmd}' not accepted")
+            if job.cancelled.wait(BUSY_RETRY_INTERVAL_S):
+                return ""
@@ -0,0 +1,177 @@
+"""HTTP load generator for app.py.
+
+Concurrent clients fire jog, pipette and halt requests at /send and the
+run is summarized as latency percentiles, throughput, dropped and
+mismatched replies, and halt latency. Point the server at emulated robots
+to measure the host alone:
+
+    python3 emulator.py -n 2                  # prints robot0=/dev/pts/3 robot1=/dev/pts/4
+    ./run.sh robot0=/dev/pts/3 robot1=/dev/pts/4
+    python3 loadtest.py --clients 8 --duration 30
+"""
+import argparse
+import json
+import random
+import threading
+import time
+import urllib.error
+import urllib.request
+from collections import defaultdict
+
+# Relative frequency of each request kind
+DEFAULT_MIX = {"jog": 6, "pipette": 3, "halt": 1}
+
+# How long a jog button is "held" (s) and the GUI keepalive period (s)
+JOG_HOLD_S = (0.2, 1.0)
+JOG_KEEPALIVE_S = 0.1
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of a non-empty list."""
+    ordered = sorted(values)
+    index = max(0, min(len(ordered) - 1, round(p / 100 * len(ordered) + 0.5) - 1))
+    return ordered[index]
+
+
+class Stats:
+    """Thread-safe collection of per-kind latencies and reply checks."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latency = defaultdict(list)
+        self.errors = defaultdict(int)
+        self.dropped = defaultdict(int)
+        self.mismatched = defaultdict(int)
+        self.examples = []
+
+    def record(self, kind, seconds, reply, expected, required):
+        """required: an empty reply counts as dropped (the firmware always answers)."""
+        with self.lock:
+            self.latency[kind].append(seconds)
+            if reply is None:
+                self.errors[kind] += 1
+            elif reply == "":
+                if required:
+                    self.dropped[kind] += 1
+            elif reply not in expected:
+                self.mismatched[kind] += 1
+                if len(self.examples) < 10:
+                    self.examples.append(f"{kind}: expected one of {sorted(expected)}, got {reply!r}")
+
+
+class Client(threading.Thread):
+    """One operator: picks a request kind at random and waits for each reply."""
+
+    def __init__(self, url, robot, mix, stats, deadline, seed):
+        super().__init__(daemon=True)
+        self.url = url.rstrip("/") + "/send"
+        self.robot = robot
+        self.kinds = [kind for kind, weight in mix.items() for _ in range(weight)]
+        self.stats = stats
+        self.deadline = deadline
+        self.random = random.Random(seed)
+
+    def post(self, payload):
+        """POST to /send; returns (seconds, received or None on failure)."""
+        if self.robot is not None:
+            payload["robot"] = self.robot
+        body = json.dumps(payload).encode()
+        request = urllib.request.Request(self.url, data=body, headers={"Content-Type": "application/json"})
+        start = time.monotonic()
+        try:
+            with urllib.request.urlopen(request, timeout=30) as res:
+                data = json.load(res)
+        except (urllib.error.URLError, OSError, ValueError):
+            return time.monotonic() - start, None
+        if data.get("status") != "ok":
+            return time.monotonic() - start, None
+        return time.monotonic() - start, data.get("received", "")
+
+    def run(self):
+        while time.monotonic() < self.deadline:
+            getattr(self, "run_" + self.random.choice(self.kinds))()
+
+    def run_jog(self):
+        axis = self.random.choice("XYZ")
+        speed = 5 if axis == "Z" else 50
+        velocity = self.random.choice((speed, -speed))
+
+        def frame(v, keepalive):
+            return {"type": "jog", "payload": {"axis": axis, "velocity": v, "keepalive": keepalive}}
+
+        # A busy robot stays silent, so "" is a legal answer to jog frames
+        seconds, reply = self.post(frame(velocity, False))
+        self.stats.record("jog start", seconds, reply, {f"Jog {axis}"}, required=False)
+
+        hold_until = time.monotonic() + self.random.uniform(*JOG_HOLD_S)
+        while time.monotonic() < hold_until:
+            time.sleep(JOG_KEEPALIVE_S)
+            seconds, reply = self.post(frame(velocity, True))
+            self.stats.record("jog keepalive", seconds, reply, set(), required=False)
+
+        # Stop frames are always answered
+        seconds, reply = self.post(frame(0, False))
+        self.stats.record("jog stop", seconds, reply, {"Stop Jog"}, required=True)
+
+    def run_pipette(self):
+        command = self.random.choice(("PULL", "PUSH"))
+        value = self.random.choice((0.2, 0.4, 1.0))
+        seconds, reply = self.post({"type": "syringes", "payload": {"command": command, "value": value}})
+        word = command.capitalize()
+        expected = {f"{word} {value:.1f} ml", f"{word} request rejected"}
+        self.stats.record("pipette", seconds, reply, expected, required=False)
+
+    def run_halt(self):
+        # Halt is always answered, whatever the robot is doing
+        seconds, reply = self.post({"type": "halt"})
+        self.stats.record("halt", seconds, reply, {"Halt Robot"}, required=True)
+        time.sleep(self.random.uniform(0.5, 2.0))
+
+
+def report(stats, elapsed):
+    total = sum(len(v) for v in stats.latency.values())
+    print(f"\n{total} requests in {elapsed:.1f} s ({total / elapsed:.1f} req/s)\n")
+    print(f"{'kind':15} {'count':>6} {'p50 ms':>8} {'p90 ms':>8} {'p99 ms':>8} {'max ms':>8}"
+          f" {'errors':>7} {'dropped':>8} {'mismatch':>9}")
+    for kind in sorted(stats.latency):
+        values = [v * 1000 for v in stats.latency[kind]]
+        print(f"{kind:15} {len(values):6d} {percentile(values, 50):8.1f} {percentile(values, 90):8.1f}"
+              f" {percentile(values, 99):8.1f} {max(values):8.1f} {stats.errors[kind]:7d}"
+              f" {stats.dropped[kind]:8d} {stats.mismatched[kind]:9d}")
+
+    if stats.latency.get("halt"):
+        halts = [v * 1000 for v in stats.latency["halt"]]
+        print(f"\nhalt latency: p50 {percentile(halts, 50):.1f} ms, p99 {percentile(halts, 99):.1f} ms,"
+              f" max {max(halts):.1f} ms")
+    for example in stats.examples:
+        print(f"  mismatch {example}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load test for the pipette robot server")
+    parser.add_argument("--url", default="http://127.0.0.1:5000")
+    parser.add_argument("--robot", default=None, help="robot name (default: server's first robot)")
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--duration", type=float, default=30, help="seconds")
+    parser.add_argument("--mix", default=None, help='weights, e.g. "jog=6,pipette=3,halt=1"')
+    parser.add_argument("--seed", type=int, default=0)
+    args = parser.parse_args()
+
+    mix = dict(DEFAULT_MIX)
+    if args.mix:
+        mix = {k: int(v) for k, v in (item.split("=") for item in args.mix.split(","))}
+
+    stats = Stats()
+    start = time.monotonic()
+    deadline = start + args.duration
+    clients = [Client(args.url, args.robot, mix, stats, deadline, args.seed + i) for i in range(args.clients)]
+    for client in clients:
+        client.start()
+    for client in clients:
+        client.join()
+
+    report(stats, time.monotonic() - start)
+
+
+if __name__ == "__main__":
+    main()
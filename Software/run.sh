@@ -1,3 +1,4 @@
 #!/bin/bash
 
-python3 app.py
+# Robots as name=port arguments (or ROBOT_PORTS=name=port,...); defaults to /dev/ttyACM0
+python3 app.py "$@"
@@ -7,6 +7,7 @@ document.addEventListener("DOMContentLoaded", () => {
     const liftButtons = document.querySelectorAll("button[data-lift]");
     const syringesButtons = document.querySelectorAll("button[data-syringes]");
     const syringesInputs = document.querySelectorAll("input[data-spinbox]");
+    const liquidSelect = document.getElementById("liquidSelect");
 
     // Get syringe-related UI elements
     const pullSpinBox = document.getElementById("pullValue");
@@ -18,6 +19,10 @@ document.addEventListener("DOMContentLoaded", () => {
     const messageLog = document.getElementById("messageLog");
     const haltButton = document.getElementById("haltButton");
 
+    // Robot selection and fleet status table
+    const robotSelect = document.getElementById("robotSelect");
+    const robotTableBody = document.querySelector("#robotTable tbody");
+
     // Initialize syringe state values from UI
     let aspiratedAmount = Number(document.getElementById("aspiratedValue").textContent);
     let remainingAmount = Number(document.getElementById("remainingValue").textContent);
@@ -39,6 +44,9 @@ document.addEventListener("DOMContentLoaded", () => {
 
         console.log("Send command");
 
+        // Address the robot currently selected in the GUI
+        command.robot = robotSelect.value || null;
+
         try {
             const res = await fetch("/send", {
                 method: "POST",
@@ -57,69 +65,72 @@ document.addEventListener("DOMContentLoaded", () => {
 
             // Log received message from the server
             console.log(`received : ${data.received}`);
-            appendToLog(data.received)
+            if (data.status === "ok" && data.received) {
+                appendToLog(`[${data.robot}] ${data.received}`);
+            }
+            else if (data.status === "error") {
+                appendToLog(`[${data.robot ?? "server"}] ${data.message}`);
+            }
 
         } catch (err) {
             console.log(`Fetch error: ${err}`);
         }
     }
 
-    // XY movement button handling
-    xyButtons.forEach(btn => {
-        const type = "xy";
-        const cmd = btn.getAttribute("data-xy");
-
-        // Command template for XY control
-        const data = {
-            type: type,
+    // Jog speeds (mm/s) and keepalive period (ms).
+    // The firmware ramps down to a stop if no frame arrives for 250 ms.
+    const XY_JOG_SPEED = 50;
+    const LIFT_JOG_SPEED = 5;
+    const JOG_KEEPALIVE_MS = 100;
+
+    // Velocity jog while a button is held: one start frame, keepalive frames
+    // every JOG_KEEPALIVE_MS, and a zero-velocity frame on release.
+    // If the browser or network stalls, the firmware's deadman stops the axis.
+    function bindJogButton(btn, label, cmd, speed) {
+        const axis = cmd[0];
+        const sign = (cmd[1] === "+") ? 1 : -1;
+        let timer = null;
+
+        const frame = (velocity, keepalive) => ({
+            type: "jog",
             payload: {
-                command: cmd,
-                state: null,
+                axis: axis,
+                velocity: velocity,
+                keepalive: keepalive,
             },
-        }
+        });
 
-        // Send "pressed" state when button is held down
-        btn.addEventListener("pointerdown", () => {
-            data.payload.state = "pressed"
-            console.log(`XY: ${cmd} pressed`);
-            sendCommand(data)
+        const stop = () => {
+            if (timer === null) return;
+            clearInterval(timer);
+            timer = null;
+            console.log(`${label}: ${cmd} released`);
+            sendCommand(frame(0, false));
+        };
+
+        btn.addEventListener("pointerdown", (e) => {
+            if (timer !== null) return;
+            // Keep receiving pointerup even if the pointer leaves the button
+            btn.setPointerCapture(e.pointerId);
+            console.log(`${label}: ${cmd} pressed`);
+            sendCommand(frame(sign * speed, false));
+            timer = setInterval(() => sendCommand(frame(sign * speed, true)), JOG_KEEPALIVE_MS);
         });
 
-        // Send "released" state when button is released
-        btn.addEventListener("pointerup", () => {
-            data.payload.state = "released"
-            console.log(`XY: ${cmd} released`);
-            sendCommand(data)
-        })
+        btn.addEventListener("pointerup", stop);
+        btn.addEventListener("pointercancel", stop);
+        btn.addEventListener("lostpointercapture", stop);
+        window.addEventListener("blur", stop);
+    }
+
+    // XY movement button handling
+    xyButtons.forEach(btn => {
+        bindJogButton(btn, "XY", btn.getAttribute("data-xy"), XY_JOG_SPEED);
     })
 
     // Lift control button handling
     liftButtons.forEach(btn => {
-        const type = "lift";
-        const cmd = btn.getAttribute("data-lift");
-
-        // Command template for lift control
-        const data = {
-            type: type,
-            payload: {
-                command: cmd,
-                state: null,
-            },
-        };
-
-        // Send "pressed" state
-        btn.addEventListener("pointerdown", () => {
-            data.payload.state = "pressed";
-            console.log(`Lift: ${cmd} pressed`);
-            sendCommand(data);
-        });
-
-        // Send "released" state
-        btn.addEventListener("pointerup", () => {
-            data.payload.state = "released";
-            console.log(`Lift: ${cmd} released`);
-            sendCommand(data);
-        })
+        bindJogButton(btn, "Lift", btn.getAttribute("data-lift"), LIFT_JOG_SPEED);
     })
 
     // Update spinbox limits after pulling liquid
@@ -194,6 +205,7 @@ document.addEventListener("DOMContentLoaded", () => {
                 payload: {
                     command: cmd,
                     value: value,
+                    liquid: liquidSelect.value,
                 },
             };
 
@@ -228,6 +240,52 @@ document.addEventListener("DOMContentLoaded", () => {
         });
     });
 
+    // Fill the robot table (and the selector on first load) from the server
+    async function refreshRobots() {
+        try {
+            const res = await fetch("/robots");
+            const data = await res.json();
+            const robots = data.robots ?? [];
+
+            if (robotSelect.options.length === 0) {
+                robots.forEach(robot => {
+                    robotSelect.add(new Option(robot.name, robot.name));
+                });
+                if (robots.length > 0) {
+                    setSyringesStatus(robots[0].aspirated_ml);
+                }
+            }
+
+            robotTableBody.replaceChildren(...robots.map(robot => {
+                const row = document.createElement("tr");
+                const status = !robot.connected ? "offline" : (robot.busy ? "busy" : "idle");
+                row.className = status;
+                [robot.name, robot.port, status, robot.job ?? "-",
+                 robot.aspirated_ml.toFixed(1), robot.last_reply].forEach(value => {
+                    const cell = document.createElement("td");
+                    cell.textContent = value;
+                    row.appendChild(cell);
+                });
+                return row;
+            }));
+        } catch (err) {
+            console.log(`Fetch error: ${err}`);
+        }
+    }
+
+    // Switching robots loads that robot's syringe volume into the panel
+    robotSelect.addEventListener("change", async () => {
+        const res = await fetch("/robots");
+        const data = await res.json();
+        const robot = (data.robots ?? []).find(r => r.name === robotSelect.value);
+        if (robot) {
+            setSyringesStatus(robot.aspirated_ml);
+        }
+    });
+
+    refreshRobots();
+    setInterval(refreshRobots, 1000);
+
     // Emergency halt button handling
     haltButton.addEventListener("click", () => {
         const type = "halt";
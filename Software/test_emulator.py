@@ -0,0 +1,36 @@
+import unittest
+
+from emulator import FirmwareEmulator, atol
+
+
+class MalformedLineTest(unittest.TestCase):
+    """Malformed plain-text lines are answered like the firmware does (atol() numbers)."""
+
+    @staticmethod
+    def answer(line):
+        # A fresh, idle robot per line; fetch() only, the serial threads never start
+        return FirmwareEmulator().fetch(line)
+
+    def test_atol(self):
+        self.assertEqual(atol("12"), 12)
+        self.assertEqual(atol("-7mm"), -7)
+        self.assertEqual(atol("abc"), 0)
+        self.assertEqual(atol(""), 0)
+
+    def test_unknown_mix_class_halts(self):
+        self.assertEqual(self.answer("MIX 1 1 0 0 bogus"), "Halt Robot")
+
+    def test_non_numeric_arguments_read_as_zero(self):
+        self.assertEqual(self.answer("PULL abc"), "Pull 0.0 ml")
+        self.assertEqual(self.answer("PUSH abc water"), "Push 0.0 ml")
+        self.assertEqual(self.answer("JOG X abc"), "Stop Jog")
+        self.assertEqual(self.answer("LABWARE x"), "Labware 0 cleared")
+        self.assertEqual(self.answer("DECK abc"), "Deck set")
+        self.assertEqual(self.answer("MIX abc"), "Mix request rejected")
+
+    def test_class_without_flow_halts(self):
+        self.assertEqual(self.answer("LIQUID foo abc"), "Halt Robot")
+
+
+if __name__ == "__main__":
+    unittest.main()